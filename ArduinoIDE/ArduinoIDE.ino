@@ -8,6 +8,8 @@
 		compiler.cppstd=gnu++17
 		compiler.cpp.flags=-std={compiler.cppstd} {compiler.warning_flags}
 	3. Restart the IDE, and errors w/ std::optional shouldn't occur.
+	To see debugging statements, add -DSR_LEVEL=1 to the end of the compiler.cpp.flags line (0 also shows trace
+	statements; see SerialStream.h). A #define in this file doesn't reach the other source files.
 
 	The board uses SPIFFS to upload the filesystem located in '/data'. For more info, visit
 		https://docs.arduino.cc/tutorials/nano-esp32/spiff/ 
@@ -15,17 +17,13 @@
 */
 
 #include "WebSocketBridge.h"                                                     // Websocket bridge
-#ifndef PRINT_DEBUG                                                 // Macro enabling debugging statements
-                                                                    // To disable, just delete these three lines
-	#define PRINT_DEBUG                                                          // Define if not already defined
-#endif
                                                                                  //
 WebSocketBridge ws;                                                              // Websocket bridge object
 void setup() {                                                                   // Attempt to setup
 	try {
 		ws.setup();
 	} catch (...) {
-		sr::out << "Failed to start WebSocket server." << sr::endl;
+		sr::error << "Failed to start WebSocket server." << sr::endl;
 		esp_deep_sleep_start();                                                  // Deep sleep if failure
 	}
 }
@@ -0,0 +1,75 @@
+#include "AssistController.h"
+
+void AssistController::setMode(const Mode mode) {
+    mode_ = mode;
+    reset();
+}
+
+void AssistController::reset() {
+    integral_ = 0;
+    lastTimestamp_ = 0;
+    error_ = 0;
+}
+
+int64_t AssistController::mapped(const int64_t angle) const {
+    return static_cast<int64_t>(offset_) * ServoController::MILLI + gain_ * angle / 100;
+}
+
+/* ------ One control step ------
+ * dt is the time since the previous frame used; it's 0 on the first frame after a reset() and after a gap longer than
+ * MAX_GAP_PERIODS frame periods (sampling stopped, or frames lost), which zeroes the integral's step, the derivative
+ * and the slew allowance for that frame. The limit follows limits.framePeriod, so timer jitter at any sampling
+ * interval or decimation never counts as a gap. Products are taken in 64 bits: the integral term is KI (‰) · 0.01º·µs, over 10^9 for 0.01º.
+ */
+bool AssistController::update(const FlexSensorArray::Frame &frame, const Limits &limits, MilliDegrees &setpoint) {
+    if (mode_ == OFF) return false;
+    int32_t sum = 0;
+    int32_t count = 0;
+    for (size_t i = 0; i < FlexSensorArray::SIZE; i++) {
+        const uint8_t bit = 1 << i;
+        if (!(channels_ & bit) || !(frame.mask & bit) || frame.angles[i] == FlexCalibration::NO_ANGLE) continue;
+        sum += frame.angles[i];
+        count++;
+    }
+    if (count == 0) {
+        holds_++;
+        return false;
+    }
+    const int32_t angle = sum / count;
+    uint64_t dt = lastTimestamp_ == 0 ? 0 : frame.timestamp - lastTimestamp_;
+    if (dt > MAX_GAP_PERIODS * limits.framePeriod) dt = 0;
+    const int64_t derivative = dt == 0 ? 0 : static_cast<int64_t>(angle - lastAngle_) * 1000000 / static_cast<int64_t>(dt);
+    lastAngle_ = angle;
+    lastTimestamp_ = frame.timestamp;
+    error_ = target_ - angle;
+
+    int64_t error = error_;
+    if (mode_ == ASSIST) {                                          // only the part of the error beyond the band
+        if (error > deadband_) error -= deadband_;
+        else if (error < -deadband_) error += deadband_;
+        else error = 0;
+    }
+    int64_t integral = integral_;
+    if (ki_ != 0) {
+        const int64_t limit = INTEGRAL_LIMIT * 1000000000LL / ki_;  // KI term of at most ±INTEGRAL_LIMIT
+        integral += error * static_cast<int64_t>(dt);
+        integral = integral > limit ? limit : integral < -limit ? -limit : integral;
+    }
+    const int64_t correction = mode_ == MAP ? 0
+        : kp_ * error / 1000 + ki_ * integral / 1000000000LL - kd_ * derivative / 1000;
+    const int64_t base = mode_ == PID ? target_ : angle;
+    const int64_t wanted = mapped(base + correction);
+
+    int64_t out = wanted;
+    const int64_t step = static_cast<int64_t>(limits.maxVelocity) * static_cast<int64_t>(dt) / 1000;
+    if (out > limits.current + step) out = limits.current + step;
+    if (out < limits.current - step) out = limits.current - step;
+    if (out > limits.high) out = limits.high;
+    if (out < limits.low) out = limits.low;
+    const bool raises = (gain_ > 0) == (error > 0);                 // the integral's step moves the servo up
+    if (!(wanted > out && raises) && !(wanted < out && !raises)) {  // else pinned and pushing further: no windup
+        integral_ = integral;
+    }
+    setpoint = static_cast<MilliDegrees>(out);
+    return true;
+}
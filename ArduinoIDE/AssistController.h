@@ -0,0 +1,120 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  On-device flex -> servo control. update() takes each frame the FlexSensorArray produces and works out the servo
+ *  setpoint for it in the same control-task pass, so the servo answers within one sample period instead of a round
+ *  trip through the browser. The browser only sets the mode, mapping, gains and target.
+ *      >> The measured angle is the mean of the calibrated angles of the selected channels (setChannels(), bit i =
+ *         FLEX_(i + 2)). A frame with none of them calibrated leaves the servo where it is.
+ *      >> The mapping turns a finger angle into a servo angle: offset + gain · angle (setOffset(), setGain(); a
+ *         negative gain for a servo mounted the other way round).
+ *      >> MAP: the servo follows the mapped finger angle (mirroring).
+ *         PID: the servo is driven so the finger reaches the target: mapping(target + correction), the correction
+ *              being a PID on the finger's error (derivative on the measurement, so a new target doesn't kick).
+ *         ASSIST: assist-as-needed. The servo follows the finger (mapping(angle + correction)) and only adds a
+ *              correction once the error is outside the deadband, by the PID on the error beyond it. Inside the
+ *              band the patient moves unassisted.
+ *      >> Gains are unitless (finger degrees of correction per degree of error), in thousandths: KP per degree, KI
+ *         per degree·second, KD per degree/second.
+ *      >> The setpoint is clamped to the limits update() is given (the servo's start/stop angles) and slewed at most
+ *         maxVelocity º/s, so the first frame after switching on holds the servo where it was. The integral stops
+ *         growing while the output is pinned at a limit (no windup).
+ *  All arithmetic is integer: angles in hundredths of a degree (as in the frame), setpoints in MilliDegrees, the
+ *  integral in hundredths of a degree times µs.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <Arduino.h>
+#include "FlexSensorArray.h"
+#include "ServoController.h"
+
+class AssistController {                    //  Flex frames in, servo setpoints out
+public:
+    //------------- Custom types
+    enum Mode {
+        OFF,                                                        //  No control; the servo is left alone
+        MAP,                                                        //  Servo follows the mapped finger angle
+        PID,                                                        //  Servo drives the finger to the target
+        ASSIST,                                                     //  Servo helps only outside the deadband
+        INVALID_MODE
+    };
+    static const char *modeString(const Mode mode) {
+        switch (mode) {
+            case OFF: return "OFF";
+            case MAP: return "MAP";
+            case PID: return "PID";
+            case ASSIST: return "ASSIST";
+            default: return "INVALID";
+        }
+    }
+    static Mode modeFromString(const char *mode) {
+        if (strcmp(mode, "OFF") == 0) return OFF;
+        if (strcmp(mode, "MAP") == 0) return MAP;
+        if (strcmp(mode, "PID") == 0) return PID;
+        if (strcmp(mode, "ASSIST") == 0) return ASSIST;
+        return INVALID_MODE;
+    }
+    using MilliDegrees = ServoController::MilliDegrees;
+    struct Limits {                                                 //  What the servo allows this frame
+        MilliDegrees low;                                           //  Lowest setpoint
+        MilliDegrees high;                                          //  Highest setpoint
+        MilliDegrees current;                                       //  Where the servo is now
+        uint32_t maxVelocity;                                       //  Fastest the setpoint may move (º/s)
+        uint64_t framePeriod;                                       //  Time between frames: sampling interval × decimation (µs)
+    };
+    //------------- Constants
+    static constexpr int32_t MAX_GAIN = 100000;                     //  Largest KP/KI/KD (thousandths)
+    static constexpr int32_t MAX_MAP_GAIN = 10000;                  //  Largest |mapping gain| (thousandths)
+    static constexpr int32_t MAX_DEADBAND = 90;                     //  º
+    static constexpr uint64_t MAX_GAP_PERIODS = 2;                  //  Longest time between frames still treated as one step (frame periods)
+    static constexpr int64_t INTEGRAL_LIMIT = 9000;                 //  Largest KI term (0.01º)
+    //------------- Control
+    bool update(                                                    //  Setpoint for one frame. False if the servo should be left alone
+        const FlexSensorArray::Frame &frame,                            //  Frame with calibrated angles (after FlexSensorArray::loop())
+        const Limits &limits,
+        MilliDegrees &setpoint);                                        //  Out: where to put the servo
+    void reset();                                                   //  Forget the integral and the last measurement. Call when the frame period changes
+    //------------- Settings
+    void setMode(Mode mode);                                        //  Resets the controller
+    [[nodiscard]] Mode getMode() const { return mode_; }
+    void setChannels(uint8_t mask) { channels_ = mask; }            //  Bit i = FLEX_(i + 2)
+    [[nodiscard]] uint8_t getChannels() const { return channels_; }
+    void setTarget(int degrees) { target_ = degrees * 100; }        //  Finger angle PID/ASSIST aim for (º)
+    [[nodiscard]] int getTarget() const { return target_ / 100; }
+    void setGain(int32_t thousandths) { gain_ = thousandths; }      //  Mapping gain (servo º per finger º, thousandths)
+    [[nodiscard]] int32_t getGain() const { return gain_; }
+    void setOffset(int degrees) { offset_ = degrees; }              //  Mapping offset (servo º at a finger angle of 0)
+    [[nodiscard]] int getOffset() const { return offset_; }
+    void setKp(int32_t thousandths) { kp_ = thousandths; }
+    [[nodiscard]] int32_t getKp() const { return kp_; }
+    void setKi(int32_t thousandths) { ki_ = thousandths; integral_ = 0; }
+    [[nodiscard]] int32_t getKi() const { return ki_; }
+    void setKd(int32_t thousandths) { kd_ = thousandths; }
+    [[nodiscard]] int32_t getKd() const { return kd_; }
+    void setDeadband(int degrees) { deadband_ = degrees * 100; }    //  ASSIST: error the patient is left to close (º)
+    [[nodiscard]] int getDeadband() const { return deadband_ / 100; }
+    //------------- Status
+    [[nodiscard]] int32_t getError() const { return error_; }       //  Target - measured angle at the last frame (0.01º)
+    [[nodiscard]] uint32_t getHolds() const { return holds_; }      //  Frames skipped: no selected channel calibrated
+private:
+    //------------- Private instance methods
+    [[nodiscard]] int64_t mapped(int64_t angle) const;              //  Servo setpoint (MilliDegrees) for a finger angle (0.01º)
+    //------------- Private instance fields
+    Mode mode_ = OFF;
+    uint8_t channels_ = 0x01;                                       //  FLEX_2
+    int32_t target_ = 4500;                                         //  0.01º
+    int32_t gain_ = 1000;                                           //  1:1
+    int32_t offset_ = 0;                                            //  º
+    int32_t kp_ = 500;
+    int32_t ki_ = 0;
+    int32_t kd_ = 0;
+    int32_t deadband_ = 500;                                        //  0.01º
+    int64_t integral_ = 0;                                          //  0.01º·µs
+    int32_t lastAngle_ = 0;                                         //  Measured angle at the last frame (0.01º)
+    uint64_t lastTimestamp_ = 0;                                    //  ... and its timestamp (µs), 0 before the first
+    int32_t error_ = 0;
+    uint32_t holds_ = 0;
+};
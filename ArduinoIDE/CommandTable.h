@@ -0,0 +1,120 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Compile-time minimal perfect hash for the command table. Each row of a table is keyed on its (dev, attr) pair;
+ *  perfectHash() builds, at compile time, a hash-and-displace index with exactly one slot per row, so a lookup is one
+ *  hash of the request's two strings, two array reads and one confirming strcmp per string.
+ *      >> The hash puts each key in one of BUCKETS buckets (about two keys per bucket). Buckets are placed largest
+ *         first: each gets the smallest displacement under which remixing the hash sends all its keys to free slots. The
+ *         index is a byte per slot and two per bucket, so it grows with the table (~2 bytes per row) and there is no
+ *         slot count to retune when rows are added.
+ *      >> If some bucket has no displacement below MAX_DISPLACEMENT, the static_assert next to the table fires;
+ *         changing SALT picks a different hash and fixes it.
+ *      >> Rows only need `const char *dev` and `const char *attr` members; what else they carry is up to the table.
+ *      >> Every slot holds a row, so unknown keys always land on one, which is why find() confirms the match with
+ *         strcmp.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace cmd {
+    constexpr uint32_t FNV_BASIS = 2166136261u;
+    constexpr uint32_t FNV_PRIME = 16777619u;
+    constexpr uint32_t SALT = 0;                                // Seed of the bucket hash
+    constexpr uint32_t MAX_DISPLACEMENT = UINT16_MAX;           // Displacements tried per bucket before giving up
+
+    /* ------ FNV-1a over a null-terminated string, continuing from h ------ */
+    constexpr uint32_t fnv1a(const char *s, uint32_t h) {
+        while (*s != '\0') {
+            h ^= static_cast<uint8_t>(*s++);
+            h *= FNV_PRIME;
+        }
+        return h;
+    }
+    /* ------ Hash of "dev:attr" under a seed (same result at compile time and at run time) ------
+     * FNV's low bits only depend on the low bits of its input, so the high bits are folded down before reducing.
+     */
+    constexpr uint32_t key(const char *dev, const char *attr, const uint32_t seed) {
+        uint32_t h = fnv1a(attr, (fnv1a(dev, FNV_BASIS ^ seed) ^ ':') * FNV_PRIME);
+        h ^= h >> 16;
+        h *= 0x45d9f3bu;
+        return h ^ (h >> 16);
+    }
+    /* ------ Slot of a key's hash under displacement d: the hash remixed, so the strings are only hashed once ------ */
+    constexpr uint32_t slot(const uint32_t hash, const uint32_t d, const size_t slots) {
+        uint32_t h = hash + (d + 1) * 0x9e3779b9u;
+        h ^= h >> 16;
+        h *= 0x45d9f3bu;
+        h ^= h >> 16;
+        return h % slots;
+    }
+
+    /* ------ Bucket displacements and slot -> row mapping found by perfectHash() ------ */
+    template <size_t N>
+    struct Index {
+        static_assert(N > 0 && N < UINT8_MAX, "Index rows must fit a byte");
+        static constexpr size_t BUCKETS = (N + 1) / 2;
+        bool found;                                             // False if some bucket couldn't be placed
+        uint16_t displacements[BUCKETS];                        // Per bucket
+        uint8_t rows[N];                                        // Row index for each slot
+    };
+
+    template <typename Row, size_t N>
+    constexpr Index<N> perfectHash(const Row (&rows)[N]) {
+        constexpr size_t BUCKETS = Index<N>::BUCKETS;
+        Index<N> index{true, {}, {}};
+        uint32_t hashes[N] = {};
+        size_t bucketOf[N] = {};
+        size_t sizes[BUCKETS] = {};
+        for (size_t i = 0; i < N; i++) {
+            hashes[i] = key(rows[i].dev, rows[i].attr, SALT);
+            bucketOf[i] = hashes[i] % BUCKETS;
+            sizes[bucketOf[i]]++;
+        }
+        bool taken[N] = {};
+        for (size_t size = N; size > 0; size--) {               // largest buckets first, while most slots are free
+            for (size_t b = 0; b < BUCKETS; b++) {
+                if (sizes[b] != size) continue;
+                size_t members[N] = {};
+                for (size_t i = 0, m = 0; i < N; i++) {
+                    if (bucketOf[i] == b) members[m++] = i;
+                }
+                bool placed = false;
+                for (uint32_t d = 0; d < MAX_DISPLACEMENT && !placed; d++) {
+                    size_t slots[N] = {};
+                    bool clash = false;
+                    for (size_t m = 0; m < size && !clash; m++) {
+                        slots[m] = slot(hashes[members[m]], d, N);
+                        clash = taken[slots[m]];
+                        for (size_t j = 0; j < m && !clash; j++) clash = slots[j] == slots[m];
+                    }
+                    if (clash) continue;
+                    for (size_t m = 0; m < size; m++) {
+                        taken[slots[m]] = true;
+                        index.rows[slots[m]] = static_cast<uint8_t>(members[m]);
+                    }
+                    index.displacements[b] = static_cast<uint16_t>(d);
+                    placed = true;
+                }
+                if (!placed) index.found = false;
+            }
+        }
+        return index;
+    }
+
+    /* ------ Row for (dev, attr), or nullptr if the table has none ------ */
+    template <typename Row, size_t N>
+    const Row *find(const Row (&rows)[N], const Index<N> &index, const char *dev, const char *attr) {
+        if (dev == nullptr || attr == nullptr) return nullptr;
+        const uint32_t hash = key(dev, attr, SALT);
+        const Row &row = rows[index.rows[slot(hash, index.displacements[hash % Index<N>::BUCKETS], N)]];
+        if (strcmp(row.dev, dev) != 0 || strcmp(row.attr, attr) != 0) return nullptr;
+        return &row;
+    }
+} // namespace cmd
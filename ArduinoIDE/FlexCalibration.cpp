@@ -0,0 +1,72 @@
+#include "FlexCalibration.h"
+
+FlexCalibration::FlexCalibration() :
+    points_{},
+    count_(0),
+    table_{},
+    built_(false)
+{}
+
+/* Insert the point in voltage order. A second capture at the same angle replaces the first, so a bad point can be
+ * retaken without clearing the whole sweep. */
+bool FlexCalibration::capture(const uint16_t reading, const int16_t angle) {
+    if (angle < 0 || angle > MAX_ANGLE) return false;
+    const Point point{static_cast<uint16_t>(hal::adcMilliVolts(reading)), angle};
+    size_t i = 0;
+    for (; i < count_ && points_[i].angle != angle; i++) {}
+    if (i < count_) {                                           // retake: remove the old point
+        for (; i + 1 < count_; i++) points_[i] = points_[i + 1];
+        count_--;
+    }
+    if (count_ == MAX_POINTS) return false;
+    for (i = count_; i > 0 && points_[i - 1].milliVolts > point.milliVolts; i--) points_[i] = points_[i - 1];
+    points_[i] = point;
+    count_++;
+    built_ = false;                                             // the table no longer matches the sweep
+    return true;
+}
+
+bool FlexCalibration::build() {
+    if (count_ < 2) return false;
+    for (size_t i = 1; i < count_; i++) {
+        if (points_[i].milliVolts == points_[i - 1].milliVolts) return false; // two angles at one voltage
+    }
+    size_t segment = 0;                                         // points_[segment] – points_[segment + 1] brackets mV
+    for (size_t n = 0; n < TABLE_SIZE; n++) {
+        const auto mV = static_cast<int32_t>(hal::adcMilliVolts(static_cast<uint16_t>(n))); // non-decreasing in n
+        if (mV <= points_[0].milliVolts) { table_[n] = points_[0].angle; continue; }
+        if (mV >= points_[count_ - 1].milliVolts) { table_[n] = points_[count_ - 1].angle; continue; }
+        while (mV > points_[segment + 1].milliVolts) segment++;
+        const Point &a = points_[segment];
+        const Point &b = points_[segment + 1];
+        const int32_t span = b.milliVolts - a.milliVolts;
+        const int32_t offset = (mV - a.milliVolts) * (b.angle - a.angle);
+        table_[n] = static_cast<int16_t>(a.angle + (offset + (offset >= 0 ? span : -span) / 2) / span); // rounded
+    }
+    built_ = true;
+    return true;
+}
+
+void FlexCalibration::clear() {
+    count_ = 0;
+    built_ = false;
+}
+
+bool FlexCalibration::save(const char *key) const {
+    Stored stored{VERSION, static_cast<uint8_t>(count_), {}};
+    for (size_t i = 0; i < count_; i++) stored.points[i] = points_[i];
+    return hal::settingsSave(key, &stored, sizeof(stored));
+}
+
+bool FlexCalibration::load(const char *key) {
+    Stored stored{};
+    if (hal::settingsLoad(key, &stored, sizeof(stored)) != sizeof(stored)) return false;
+    if (stored.version != VERSION || stored.count > MAX_POINTS) return false;
+    for (size_t i = 0; i < stored.count; i++) points_[i] = stored.points[i];
+    count_ = stored.count;
+    return build();
+}
+
+bool FlexCalibration::erase(const char *key) {
+    return hal::settingsErase(key);
+}
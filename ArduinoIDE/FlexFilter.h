@@ -0,0 +1,77 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Fixed-point kernels for the flex sensors' DSP stage, run by FlexSensorArray in the sampling timer for every channel:
+ *      oversampling    2^k back-to-back reads per tick, summed and scaled to Q16 (the average, with k extra bits)
+ *      low-pass        one-pole IIR, y += α·(x − y), α in Q16 from the cutoff frequency (α = 1 bypasses it)
+ *      decimation      boxcar FIR over M filtered ticks, one output per M ticks
+ *  Values stay in Q16 (12.16, at most 2^28) from the oversampled average to the decimator's output, so neither the
+ *  averaging nor a small α throws away resolution; a reading is rounded back to 12 bits only when it leaves the stage.
+ *      >> Nothing allocates, and the per-tick work is integer only. lowPassAlpha() uses floating point, but it only
+ *         runs when the cutoff or the sampling interval changes (loop context).
+ *      >> A channel's state is plain data owned by the timer. Reset it (= {}) when the channel stops being sampled so
+ *         it restarts from its next reading instead of ramping up from a stale one.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+namespace dsp {
+    constexpr uint8_t FRACTION = 16;                            // Fractional bits of the Q16 values
+    constexpr uint32_t ONE = 1u << FRACTION;                    // α of 1.0: the low-pass passes its input through
+    constexpr uint16_t READING_MAX = 4095;                      // 12-bit ADC
+
+    /* ------ Sum of 2^shift readings -> their average in Q16 ------ */
+    constexpr int32_t fromSum(const uint32_t sum, const uint8_t shift) {
+        return static_cast<int32_t>(sum << (FRACTION - shift));
+    }
+    /* ------ Q16 -> 12-bit reading, rounded and clamped ------ */
+    constexpr uint16_t toReading(const int32_t value) {
+        const int32_t rounded = (value + (1 << (FRACTION - 1))) >> FRACTION;
+        return rounded < 0 ? 0 : rounded > READING_MAX ? READING_MAX : static_cast<uint16_t>(rounded);
+    }
+    /* ------ α (Q16) of a one-pole low-pass with a -3 dB point at cutoff, sampled every interval ------
+     * A cutoff of 0 means no filtering. α = 1 - e^(-2π·fc·T), at least one LSB so the output still converges.
+     */
+    inline uint32_t lowPassAlpha(const uint32_t cutoffMilliHz, const uint64_t intervalUs) {
+        if (cutoffMilliHz == 0) return ONE;
+        const double alpha = 1.0 - std::exp(-2.0 * M_PI * (cutoffMilliHz / 1000.0) * (static_cast<double>(intervalUs) / 1e6));
+        const auto q = static_cast<uint32_t>(std::lround(alpha * ONE));
+        return q < 1 ? 1 : q > ONE ? ONE : q;
+    }
+
+    /* ------ One-pole IIR low-pass ------ */
+    struct LowPass {
+        int32_t y;                                              // Output, Q16
+        bool primed;                                            // Whether y holds a value yet
+        int32_t step(const int32_t x, const uint32_t alpha) {
+            if (!primed) {                                      // start at the first reading rather than ramping up from 0
+                y = x;
+                primed = true;
+            } else {
+                y += static_cast<int32_t>((static_cast<int64_t>(x - y) * alpha) >> FRACTION);
+            }
+            return y;
+        }
+    };
+
+    /* ------ Boxcar FIR decimator: averages everything added since the last take() ------ */
+    struct Decimator {
+        int64_t sum;                                            // Q16 values added (up to 255 of 2^28)
+        uint8_t count;
+        void add(const int32_t x) {
+            sum += x;
+            count++;
+        }
+        int32_t take() {
+            const int32_t average = count != 0 ? static_cast<int32_t>(sum / count) : 0;
+            sum = 0;
+            count = 0;
+            return average;
+        }
+    };
+} // namespace dsp
@@ -0,0 +1,180 @@
+
+#include "FlexSensorArray.h"
+
+/* Constructor. The sensors start disconnected; the bridge assigns their pins after setup(). */
+FlexSensorArray::FlexSensorArray() :
+    sensors_{
+        FlexSensor("FLEX_2"),
+        FlexSensor("FLEX_3"),
+        FlexSensor("FLEX_4"),
+        FlexSensor("FLEX_5")
+    },
+    frameNotifier_(nullptr),
+    wake_(nullptr),
+    samplingTimer_(nullptr),
+    samplingInterval_(100000),                                  //  10 Hz
+    sequence_(0),
+    oversampleShift_(0),                                        //  one read per channel per scan
+    alpha_(dsp::ONE),                                           //  low-pass bypassed
+    decimation_(1),                                             //  one frame per scan
+    cutoff_(0),
+    scans_(0),
+    filters_{},
+    decimators_{},
+    pins_{},
+    failed_(false)
+{}
+
+FlexSensorArray::~FlexSensorArray() {
+    if (samplingTimer_ == nullptr) return;
+    hal::timerStop(samplingTimer_);
+    hal::timerDelete(samplingTimer_);
+}
+
+/* Scan every connected sensor back-to-back through the DSP stage, and queue a frame every decimation_ scans.
+ * This is the only producer of frames_. */
+void FlexSensorArray::onTimer(void *arg) {
+    const auto self = static_cast<FlexSensorArray*>(arg);
+    const uint64_t timestamp = hal::micros();
+    const uint8_t shift = self->oversampleShift_.load(std::memory_order_relaxed);
+    const uint32_t alpha = self->alpha_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < SIZE; i++) {
+        std::optional<uint8_t> pin;
+        const auto sum = self->sensors_[i].read(static_cast<uint8_t>(1u << shift), &pin);
+        if (pin != self->pins_[i]) {                            // disconnected or moved: drop the old pin's state
+            self->pins_[i] = pin;
+            self->filters_[i] = {};
+            self->decimators_[i] = {};
+        }
+        if (sum.has_value()) self->decimators_[i].add(self->filters_[i].step(dsp::fromSum(sum.value(), shift), alpha));
+    }
+    if (++self->scans_ < self->decimation_.load(std::memory_order_relaxed)) return;
+    self->scans_ = 0;
+    Frame frame{};
+    frame.timestamp = timestamp;
+    for (size_t i = 0; i < SIZE; i++) {
+        if (self->decimators_[i].count == 0) continue;          // not sampled during this frame
+        frame.mask |= 1u << i;
+        frame.readings[i] = dsp::toReading(self->decimators_[i].take());
+    }
+    if (frame.mask == 0) return;                                // no frame, so no sequence number used up
+    frame.sequence = self->sequence_++;
+    if (!self->frames_.push(frame)) return;                     // counts an overrun if loop() fell behind
+    if (self->wake_ != nullptr) self->wake_->signal();
+}
+
+void FlexSensorArray::setup() {
+    failed_ = false;
+    for (auto &sensor : sensors_) sensor.loadCalibration();
+    if (samplingTimer_ != nullptr) {
+        sr::out << "Flex sensors already initialized. Deleting old timer." << sr::endl;
+        hal::timerStop(samplingTimer_);
+        hal::timerDelete(samplingTimer_);
+        samplingTimer_ = nullptr;
+    }
+    if (const hal::Error err = hal::timerCreate(onTimer, this, "flex", &samplingTimer_); err != hal::OK) {
+        sr::error << "Failed to create flex sampling timer: " << hal::errorName(err) << sr::endl;
+        failed_ = true;
+    }
+}
+
+/* Drain every queued frame, in order. This is the only consumer of frames_. */
+void FlexSensorArray::loop() {
+    Frame frame;
+    while (frames_.pop(frame)) {
+        for (size_t i = 0; i < SIZE; i++) {
+            frame.angles[i] = FlexCalibration::NO_ANGLE;
+            if (!(frame.mask & (1u << i))) continue;
+            frame.angles[i] = sensors_[i].angle(frame.readings[i]);
+            sensors_[i].update({frame.readings[i], frame.timestamp, frame.sequence, frame.angles[i]});
+        }
+        if (frameNotifier_) frameNotifier_(frame);
+    }
+}
+
+bool FlexSensorArray::setSamplingInterval(const uint64_t interval) {
+    if (interval < MIN_SAMPLING_INTERVAL) {
+        sr::warn << "new sampling interval (" << interval << ") cannot be < " << MIN_SAMPLING_INTERVAL << " µs." << sr::endl;
+        return false;
+    }
+    if (!fitsInterval(interval, getOversample())) {
+        sr::warn << "new sampling interval (" << interval << ") is too short for " << getOversample() << "x oversampling." << sr::endl;
+        return false;
+    }
+    if (static_cast<uint64_t>(cutoff_) * 2 >= 1000000000ULL / interval) {
+        sr::warn << "new sampling interval (" << interval << ") puts the " << cutoff_ << " mHz cutoff above half the sampling rate." << sr::endl;
+        return false;
+    }
+    const bool wasActive = getActive();
+    if (wasActive) hal::timerStop(samplingTimer_);
+    samplingInterval_ = interval;
+    alpha_ = dsp::lowPassAlpha(cutoff_, samplingInterval_);
+    sr::out << "new sampling interval: " << samplingInterval_ << sr::endl;
+    if (wasActive) hal::timerStartPeriodic(samplingTimer_, samplingInterval_);
+    return true;
+}
+
+bool FlexSensorArray::fitsInterval(const uint64_t interval, const uint8_t oversample) const {
+    return 2 * oversample * SIZE * READ_TIME <= interval;
+}
+
+bool FlexSensorArray::setOversample(const uint8_t count) {
+    if (count == 0 || count > MAX_OVERSAMPLE || (count & (count - 1)) != 0) {
+        sr::warn << "oversampling (" << count << ") must be a power of two from 1 to " << MAX_OVERSAMPLE << "." << sr::endl;
+        return false;
+    }
+    if (!fitsInterval(samplingInterval_, count)) {
+        sr::warn << count << "x oversampling doesn't fit the " << samplingInterval_ << " µs sampling interval." << sr::endl;
+        return false;
+    }
+    uint8_t shift = 0;
+    while ((1u << shift) < count) shift++;
+    oversampleShift_ = shift;
+    sr::out << "new oversampling: " << count << "x" << sr::endl;
+    return true;
+}
+
+bool FlexSensorArray::setCutoff(const uint32_t milliHz) {
+    if (milliHz != 0 && static_cast<uint64_t>(milliHz) * 2 >= 1000000000ULL / samplingInterval_) {
+        sr::warn << "cutoff (" << milliHz << " mHz) must be below half the sampling rate." << sr::endl;
+        return false;
+    }
+    cutoff_ = milliHz;
+    alpha_ = dsp::lowPassAlpha(cutoff_, samplingInterval_);
+    sr::out << "new low-pass cutoff: " << cutoff_ << " mHz" << sr::endl;
+    return true;
+}
+
+bool FlexSensorArray::setDecimation(const uint8_t factor) {
+    if (factor == 0 || factor > MAX_DECIMATION) {
+        sr::warn << "decimation (" << factor << ") must be from 1 to " << MAX_DECIMATION << "." << sr::endl;
+        return false;
+    }
+    decimation_ = factor;
+    sr::out << "new decimation: 1 frame per " << factor << " scans" << sr::endl;
+    return true;
+}
+
+void FlexSensorArray::setActive(const bool enable) {
+    if (failed_) {
+        sr::error << "Cannot activate sensors as setup failed. Call setup() again to reinitialize." << sr::endl;
+        return;
+    }
+    if (getActive()) {
+        if (!enable) {
+            hal::timerStop(samplingTimer_);
+            sr::out << "Flex sensors stopped." << sr::endl;
+        }
+    } else if (enable) {
+        hal::timerStartPeriodic(samplingTimer_, samplingInterval_);
+        sr::out << "Flex sensors started." << sr::endl;
+    }
+}
+
+FlexSensor *FlexSensorArray::find(const char *name) {
+    if (name == nullptr) return nullptr;
+    for (auto &sensor : sensors_) {
+        if (strcmp(sensor.getName(), name) == 0) return &sensor;
+    }
+    return nullptr;
+}
@@ -0,0 +1,130 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  This class is the sampling engine for the flex sensors. Rather than each sensor owning its own timer (four
+ *  timers and four critical sections for one logical tick), the array owns a single hal::Timer and, on each tick,
+ *  scans every attached sensor back-to-back. The readings are stamped once and handed out as a single frame, so
+ *  every finger in a frame was sampled within a few microseconds of the others.
+ *      >> The scan runs in the timer callback itself. Frames are pushed into a lock-free SPSC ring (see 'SpscRing.h')
+ *         and drained by loop(), so a late loop() delays frames instead of losing them. If the ring does fill up,
+ *         the refused frames are counted (getOverruns()) and the gap shows up in the sequence numbers. setWake()
+ *         names an event the timer signals with each frame, so the task calling loop() can sleep until there is one.
+ *      >> The default sampling interval is still 100,000 µs (10 Hz). The floor is MIN_SAMPLING_INTERVAL (1 kHz),
+ *         since one scan of all four channels takes well under 100 µs.
+ *      >> Each channel runs through a DSP stage in the timer before its reading is queued (see 'FlexFilter.h'):
+ *         oversampling (setOversample()), a one-pole low-pass (setCutoff()) and decimation by M (setDecimation()),
+ *         which queues one frame per M scans. All three default to off, and every frame is stamped with the time of
+ *         the newest scan it covers. The low-pass and the boxcar add group delay that the timestamp doesn't remove.
+ *      >> loop() converts every reading it drains to an angle with its sensor's calibration table (one lookup, see
+ *         'FlexCalibration.h') before handing the frame on. setup() restores the persisted calibrations.
+ *      >> The continuous (DMA) ADC driver isn't used: the Arduino-ESP32 2.x core this project builds against doesn't
+ *         expose it, and the pins are reassignable at runtime from the web UI. A one-shot scan per tick keeps both.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <Arduino.h>
+#include <functional>
+#include <atomic>
+#include "Hal.h"
+#include "SerialStream.h"
+#include "SpscRing.h"
+#include "FlexSensor.h"
+#include "FlexFilter.h"
+
+class FlexSensorArray {                     //  Class driving every flex sensor off one timebase
+public:
+    //------------- Constants
+    static constexpr size_t SIZE = 4;                               //  One sensor per finger, excluding the thumb
+    static constexpr uint64_t MIN_SAMPLING_INTERVAL = 1000;         //  Shortest accepted sampling interval (µs)
+    static constexpr size_t QUEUE_LENGTH = 64;                      //  Frames buffered between the timer and loop() (64 ms @ 1 kHz)
+    static constexpr uint8_t MAX_OVERSAMPLE = 16;                   //  Most reads averaged per channel per scan (power of two)
+    static constexpr uint8_t MAX_DECIMATION = 64;                   //  Most scans averaged into one frame
+    static constexpr uint64_t READ_TIME = 25;                       //  Budget for one ADC read (µs); a scan may use half the interval
+    //------------- Custom types
+    /* ------ One time-aligned scan of all sensors ------
+     * Readings of channels that aren't connected are left at 0 and their bit in the mask is cleared.
+     */
+    struct Frame {
+        uint64_t timestamp;                                         //  hal::micros() at the start of the (newest) scan (µs)
+        uint32_t sequence;                                          //  Frame counter, incremented once per frame produced
+        uint8_t mask;                                               //  Bit i set if sensors[i] was sampled
+        uint16_t readings[SIZE];                                    //  12-bit ADC readings after the DSP stage, indexed like the sensors
+        int16_t angles[SIZE];                                       //  Calibrated angles (0.01º) or FlexCalibration::NO_ANGLE, filled in by loop()
+    };
+    //------------- Constructor
+    FlexSensorArray();                                              //  Creates the FLEX_2 – FLEX_5 sensors, none connected
+    //------------- Destructor
+    ~FlexSensorArray();
+    //------------- Arduino methods
+    void setup();                                                   //  Creates the sampling timer. Call once in setup()
+    void loop();                                                    //  Drains every frame the timer has queued. Call once per loop()
+    //------------- Sampling control
+    bool setSamplingInterval(                                       //  Set the sampling interval, restarting the timer if running.
+        uint64_t interval);                                             //  New interval (µs), >= MIN_SAMPLING_INTERVAL
+    [[nodiscard]] uint64_t getSamplingInterval() const              //  Get the sampling interval (µs)
+        { return samplingInterval_; }
+    //------------- DSP stage (see 'FlexFilter.h')
+    bool setOversample(                                             //  Set the reads averaged per channel per scan.
+        uint8_t count);                                                 //  1, 2, 4, 8 or 16; needs 2·count·SIZE·READ_TIME µs per interval
+    [[nodiscard]] uint8_t getOversample() const                     //  Reads averaged per channel per scan
+        { return static_cast<uint8_t>(1u << oversampleShift_.load()); }
+    bool setCutoff(                                                 //  Set the low-pass cutoff.
+        uint32_t milliHz);                                              //  -3 dB point (mHz), 0 to bypass, below half the sampling rate
+    [[nodiscard]] uint32_t getCutoff() const                        //  Low-pass cutoff (mHz), 0 if bypassed
+        { return cutoff_; }
+    bool setDecimation(                                             //  Set the scans averaged into each frame.
+        uint8_t factor);                                                //  1 (every scan) – MAX_DECIMATION
+    [[nodiscard]] uint8_t getDecimation() const                     //  Scans averaged into each frame
+        { return decimation_.load(); }
+    void setActive(                                                 //  Start/stop sampling of all sensors
+        bool enable = true);
+    [[nodiscard]] bool getActive() const                            //  Whether the sampling timer is running
+        { return hal::timerActive(samplingTimer_); }
+    [[nodiscard]] bool setupFailed() const                          //  Whether the sampling timer couldn't be created
+        { return failed_; }
+    [[nodiscard]] uint32_t getOverruns() const                      //  Frames dropped because loop() fell QUEUE_LENGTH frames behind
+        { return frames_.overruns(); }
+    [[nodiscard]] uint32_t getQueueHighWater() const                //  Deepest the frame queue has been
+        { return frames_.highWater(); }
+    //------------- Sensor access
+    FlexSensor &operator[](size_t i) { return sensors_[i]; }
+    const FlexSensor &operator[](size_t i) const { return sensors_[i]; }
+    FlexSensor *begin() { return sensors_; }                        //  Range-for support
+    FlexSensor *end() { return sensors_ + SIZE; }
+    FlexSensor *find(                                               //  Find a sensor by its name (nullptr if none)
+        const char *name);
+    // --- WebSocketBridge notifier
+    void setFrameNotifier(                                          //  Callback invoked once per scan with the whole frame
+        std::function<void(const Frame&)> notifier)
+        { frameNotifier_ = std::move(notifier); }
+    void setWake(                                                   //  Event the timer signals whenever it queues a frame
+        hal::Event *wake)                                               //  Task running loop(); nullptr for none
+        { wake_ = wake; }
+private:
+    //------------- Private static methods
+    static void onTimer(                                            //  Callback for the sampling timer.
+        void *arg);                                                     //  Generic pointer cast back to 'this'
+    //------------- Private instance methods
+    [[nodiscard]] bool fitsInterval(                                //  Whether a scan at this oversampling fits the interval
+        uint64_t interval, uint8_t oversample) const;
+    //------------- Private instance fields
+    FlexSensor sensors_[SIZE];                                      //  The sensors, scanned in index order
+    std::function<void(const Frame&)> frameNotifier_;              //  Frame callback
+    hal::Event *wake_;                                              //  Signalled per queued frame (may be nullptr)
+    hal::Timer samplingTimer_;                                      //  The one sampling timer
+    uint64_t samplingInterval_;                                     //  Sampling interval (µs)
+    uint32_t sequence_;                                             //  Sequence number of the next frame (timer-owned)
+    std::atomic<uint8_t> oversampleShift_;                          //  log2 of the reads per channel per scan (set by loop, read by timer)
+    std::atomic<uint32_t> alpha_;                                   //  Low-pass α (Q16), dsp::ONE when bypassed
+    std::atomic<uint8_t> decimation_;                               //  Scans per frame
+    uint32_t cutoff_;                                               //  Low-pass cutoff (mHz), kept to recompute α on interval changes
+    uint8_t scans_;                                                 //  Scans since the last frame (timer-owned)
+    dsp::LowPass filters_[SIZE];                                    //  Per-channel DSP state (timer-owned)
+    dsp::Decimator decimators_[SIZE];
+    std::optional<uint8_t> pins_[SIZE];                             //  Pin the channel's DSP state was built from (timer-owned)
+    SpscRing<Frame, QUEUE_LENGTH> frames_;                          //  Timer (producer) -> loop() (consumer)
+    bool failed_;                                                   //  Flag indicating failure status
+};
@@ -0,0 +1,233 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Thin hardware abstraction layer: the ADC, PWM, timer, clock, settings and critical-section calls the sensor and servo
+ *  classes make, in one place. On the board (ARDUINO defined) every function is an inline forward to the Arduino/ESP-IDF call
+ *  it replaces, so there's no cost to going through it. Anywhere else the functions are only declared here and come
+ *  from the simulator in 'src/native/' (see 'include/native/Sim.h'), which runs on a virtual clock.
+ *      >> Timers follow esp_timer: callbacks are dispatched from a task (never an ISR), one-shot or periodic, and
+ *         stopping an inactive timer is an error.
+ *      >> Events wake a waiting task (a FreeRTOS task notification on the board). Timer callbacks signal one when
+ *         they leave work for a loop(), so the task running it can block instead of polling.
+ *      >> Critical sections nest the same way portENTER_CRITICAL does. Prefer hal::Critical over calling
+ *         enter()/exit() by hand.
+ *      >> adcMilliVolts() converts a raw reading with the ADC characteristics burned into eFuse at the factory (two-point
+ *         fit on the S3, reference voltage on older chips, a nominal 1100 mV if neither is there). Every flex pin is on
+ *         ADC1 at the Arduino core's default 11 dB attenuation, so one characterization covers all of them.
+ *      >> PWM is LEDC: a channel is set up with a frequency and a duty resolution, pins are attached to it, and duty is
+ *         written to the channel (0 – 2^bits - 1), so every pin on it follows.
+ *      >> Settings are small blobs kept in NVS under one namespace, so they survive a reboot or a re-flash of the
+ *         firmware (but not an erase of the whole flash). Keys are at most 15 characters.
+ *      >> tasks() is uxTaskGetSystemState(): every task's run time (µs on the ESP32's run-time clock), least free
+ *         stack and core. A core that doesn't compile in the trace facility reports no tasks; one without run-time
+ *         stats reports them with a run time (and clock) of 0.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <Preferences.h>
+#include <esp_adc_cal.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+namespace hal {
+#ifdef ARDUINO
+    using Error = esp_err_t;
+    using Timer = esp_timer_handle_t;
+    constexpr Error OK = ESP_OK;
+#else
+    using Error = int;
+    using Timer = struct SimTimer *;                            // Defined by the simulator
+    constexpr Error OK = 0;
+#endif
+    using TimerCallback = void (*)(void *arg);
+    constexpr const char *SETTINGS_NAMESPACE = "exo";           // NVS namespace of every settings key
+    constexpr uint32_t FOREVER = UINT32_MAX;                    // Event::wait() timeout that never expires
+    constexpr size_t MAX_TASKS = 32;                            // Tasks tasks() can report
+    constexpr size_t TASK_NAME_SIZE = 16;                       // configMAX_TASK_NAME_LEN, terminator included
+    constexpr size_t CORES = 2;
+    constexpr int8_t NO_CORE = -1;                              // TaskInfo::core of a task free to run on either
+
+    struct TaskInfo {                                           // One task, as tasks() found it
+        uint32_t id;                                            // Unique task number
+        char name[TASK_NAME_SIZE];
+        uint32_t runtime;                                       // Run-time clock while it ran (µs; wraps)
+        uint32_t stackFree;                                     // Least free stack since it started (bytes)
+        int8_t core;                                            // Core it's pinned to, or NO_CORE
+        uint8_t priority;
+        bool idle;                                              // A core's idle task
+    };
+
+    /* ------ Spinlock guarding data shared with timer callbacks ------ */
+    class Mutex {
+    public:
+#ifdef ARDUINO
+        void enter() { portENTER_CRITICAL(&mux_); }
+        void exit() { portEXIT_CRITICAL(&mux_); }
+    private:
+        portMUX_TYPE mux_ = portMUX_INITIALIZER_UNLOCKED;
+#else
+        void enter() { while (lock_.test_and_set(std::memory_order_acquire)) {} }
+        void exit() { lock_.clear(std::memory_order_release); }
+    private:
+        std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+#endif
+    };
+    /* ------ Wakes one task blocked in wait() ------
+     * signal() may come from any task or timer callback, any number of times; the waiter wakes once for all of them.
+     * On the board it's the waiting task's notification value, so there's nothing to allocate, and a signal that
+     * arrives before the task waits makes the next wait() return at once. The simulator never blocks (wait() only
+     * reports and clears a pending signal), since time only moves when the caller advances it.
+     */
+    class Event {
+    public:
+#ifdef ARDUINO
+        void attach() { task_.store(xTaskGetCurrentTaskHandle()); } // Call from the task that waits
+        void signal() {
+            if (TaskHandle_t task = task_.load(); task != nullptr) xTaskNotifyGive(task);
+        }
+        bool wait(const uint32_t timeoutMs) {                   // Whether it was signalled (false on timeout)
+            return ulTaskNotifyTake(pdTRUE, timeoutMs == FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs)) != 0;
+        }
+    private:
+        std::atomic<TaskHandle_t> task_{nullptr};               // Signals before attach() are dropped
+#else
+        void attach() {}
+        void signal() { pending_.store(true, std::memory_order_release); }
+        bool wait(uint32_t) { return pending_.exchange(false, std::memory_order_acq_rel); }
+    private:
+        std::atomic<bool> pending_{false};
+#endif
+    };
+    /* ------ RAII critical section ------ */
+    class Critical {
+    public:
+        explicit Critical(Mutex &mutex) : mutex_(mutex) { mutex_.enter(); }
+        ~Critical() { mutex_.exit(); }
+        Critical(const Critical &) = delete;
+        Critical &operator=(const Critical &) = delete;
+    private:
+        Mutex &mutex_;
+    };
+
+#ifdef ARDUINO
+    // ------ Clock ------
+    inline uint64_t micros() { return static_cast<uint64_t>(esp_timer_get_time()); }
+    inline uint32_t cycles() { return ESP.getCycleCount(); }    // This core's cycle counter (wraps every ~18 s)
+    inline uint32_t cyclesPerMicro() { return ESP.getCpuFreqMHz(); }
+    // ------ ADC ------
+    inline uint16_t adcRead(const uint8_t pin) { return analogRead(pin); }
+    inline const esp_adc_cal_characteristics_t &adcCharacteristics() {
+        static esp_adc_cal_characteristics_t characteristics;
+        static const esp_adc_cal_value_t source =                   // characterized once, on first use
+            esp_adc_cal_characterize(ADC_UNIT_1, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, 1100, &characteristics);
+        (void)source;
+        return characteristics;
+    }
+    inline uint32_t adcMilliVolts(const uint16_t reading) { return esp_adc_cal_raw_to_voltage(reading, &adcCharacteristics()); }
+    inline const char *adcCalibrationName() {
+        if (esp_adc_cal_check_efuse(ESP_ADC_CAL_VAL_EFUSE_TP_FIT) == ESP_OK) return "EFUSE_TP_FIT";
+        if (esp_adc_cal_check_efuse(ESP_ADC_CAL_VAL_EFUSE_TP) == ESP_OK) return "EFUSE_TP";
+        if (esp_adc_cal_check_efuse(ESP_ADC_CAL_VAL_EFUSE_VREF) == ESP_OK) return "EFUSE_VREF";
+        return "DEFAULT_VREF";
+    }
+    // ------ PWM ------
+    inline uint32_t pwmSetup(const uint8_t channel, const uint32_t frequency, const uint8_t bits) {   // Frequency set; 0 if it can't be
+        return static_cast<uint32_t>(ledcSetup(channel, frequency, bits));
+    }
+    inline void pwmAttach(const uint8_t pin, const uint8_t channel) { ledcAttachPin(pin, channel); }
+    inline void pwmDetach(const uint8_t pin) { ledcDetachPin(pin); }
+    inline void pwmWrite(const uint8_t channel, const uint32_t duty) { ledcWrite(channel, duty); }
+    // ------ Timers ------
+    inline Error timerCreate(const TimerCallback callback, void *arg, const char *name, Timer *timer) {
+        const esp_timer_create_args_t args{
+            .callback = callback,
+            .arg = arg,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = name,
+            .skip_unhandled_events = false
+        };
+        return esp_timer_create(&args, timer);
+    }
+    inline Error timerStartPeriodic(const Timer timer, const uint64_t periodUs) { return esp_timer_start_periodic(timer, periodUs); }
+    inline Error timerStartOnce(const Timer timer, const uint64_t timeoutUs) { return esp_timer_start_once(timer, timeoutUs); }
+    inline Error timerStop(const Timer timer) { return esp_timer_stop(timer); }
+    inline Error timerDelete(const Timer timer) { return esp_timer_delete(timer); }
+    inline bool timerActive(const Timer timer) { return timer != nullptr && esp_timer_is_active(timer); }
+    inline const char *errorName(const Error error) { return esp_err_to_name(error); }
+    // ------ Settings ------
+    inline size_t settingsLoad(const char *key, void *data, const size_t len) {   // Bytes read; 0 if missing or a different size
+        Preferences prefs;
+        if (!prefs.begin(SETTINGS_NAMESPACE, true)) return 0;   // fails until something has been saved
+        const size_t read = prefs.getBytesLength(key) == len ? prefs.getBytes(key, data, len) : 0;
+        prefs.end();
+        return read;
+    }
+    inline bool settingsSave(const char *key, const void *data, const size_t len) {
+        Preferences prefs;
+        if (!prefs.begin(SETTINGS_NAMESPACE, false)) return false;
+        const bool saved = prefs.putBytes(key, data, len) == len;
+        prefs.end();
+        return saved;
+    }
+    inline bool settingsErase(const char *key) {
+        Preferences prefs;
+        if (!prefs.begin(SETTINGS_NAMESPACE, false)) return false;
+        const bool erased = !prefs.isKey(key) || prefs.remove(key);
+        prefs.end();
+        return erased;
+    }
+    // ------ Tasks ------
+    inline size_t tasks(TaskInfo (&out)[MAX_TASKS], uint32_t &clock) {    // Tasks found (0 if more than MAX_TASKS)
+#if configUSE_TRACE_FACILITY == 1
+        TaskStatus_t status[MAX_TASKS];
+        const size_t count = uxTaskGetSystemState(status, MAX_TASKS, &clock);
+        for (size_t i = 0; i < count; i++) {
+            const BaseType_t affinity = xTaskGetAffinity(status[i].xHandle);
+            out[i].id = status[i].xTaskNumber;
+            strlcpy(out[i].name, status[i].pcTaskName, TASK_NAME_SIZE);
+            out[i].runtime = status[i].ulRunTimeCounter;
+            out[i].stackFree = status[i].usStackHighWaterMark;  // StackType_t is a byte on the ESP32
+            out[i].core = affinity == tskNO_AFFINITY ? NO_CORE : static_cast<int8_t>(affinity);
+            out[i].priority = static_cast<uint8_t>(status[i].uxCurrentPriority);
+            out[i].idle = affinity != tskNO_AFFINITY && status[i].xHandle == xTaskGetIdleTaskHandleForCPU(affinity);
+        }
+        return count;
+#else
+        clock = 0;
+        return 0;
+#endif
+    }
+#else
+    uint64_t micros();
+    uint32_t cycles();                                          // Host time in ns, not the virtual clock
+    uint32_t cyclesPerMicro();
+    uint16_t adcRead(uint8_t pin);
+    uint32_t adcMilliVolts(uint16_t reading);
+    const char *adcCalibrationName();
+    uint32_t pwmSetup(uint8_t channel, uint32_t frequency, uint8_t bits);
+    void pwmAttach(uint8_t pin, uint8_t channel);
+    void pwmDetach(uint8_t pin);
+    void pwmWrite(uint8_t channel, uint32_t duty);
+    Error timerCreate(TimerCallback callback, void *arg, const char *name, Timer *timer);
+    Error timerStartPeriodic(Timer timer, uint64_t periodUs);
+    Error timerStartOnce(Timer timer, uint64_t timeoutUs);
+    Error timerStop(Timer timer);
+    Error timerDelete(Timer timer);
+    bool timerActive(Timer timer);
+    const char *errorName(Error error);
+    size_t settingsLoad(const char *key, void *data, size_t len);
+    bool settingsSave(const char *key, const void *data, size_t len);
+    bool settingsErase(const char *key);
+    size_t tasks(TaskInfo (&out)[MAX_TASKS], uint32_t &clock);
+#endif
+} // namespace hal
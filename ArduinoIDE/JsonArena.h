@@ -0,0 +1,101 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Fixed-size bump allocator for a JsonDocument. ArduinoJson 7 always allocates dynamically (memory pools for the
+ *  variants, plus one block per string), and clear() frees all of it, so a class-scoped document still hits the heap on
+ *  every request. Handing the document a JsonArena keeps all of that in a static buffer instead.
+ *      >> Allocation bumps a pointer. Freeing the most recent block rolls the pointer back, and once every block is
+ *         freed (which is what JsonDocument::clear() does) the whole arena resets, so the next message starts from an
+ *         empty buffer.
+ *      >> When a message needs more than SIZE bytes, allocate()/reallocate() return nullptr. ArduinoJson treats that as
+ *         out of memory (DeserializationError::NoMemory when parsing, overflowed() when building), and the failure is
+ *         counted. It never falls back to the heap.
+ *      >> Not thread-safe; a document and its arena belong to one task.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <ArduinoJson.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+template <size_t SIZE>
+class JsonArena : public ArduinoJson::Allocator {
+public:
+    JsonArena() : buffer_{}, top_(0), last_(NONE), live_(0), peak_(0), failures_(0) {}
+    // ------ ArduinoJson::Allocator ------
+    void *allocate(const size_t size) override {
+        const size_t need = blockSize(size);
+        if (need > SIZE - top_) return fail();
+        Header *header = headerAt(top_);
+        header->size = size;
+        last_ = top_;
+        top_ += need;
+        live_++;
+        if (top_ > peak_) peak_ = top_;
+        return header + 1;
+    }
+    void deallocate(void *ptr) override {
+        if (ptr == nullptr) return;
+        if (offsetOf(ptr) == last_) {                           // most recent block: roll back
+            top_ = last_;
+            last_ = NONE;
+        }
+        if (--live_ == 0) {                                     // everything freed (JsonDocument::clear())
+            top_ = 0;
+            last_ = NONE;
+        }
+    }
+    void *reallocate(void *ptr, const size_t size) override {
+        if (ptr == nullptr) return allocate(size);
+        Header *header = static_cast<Header *>(ptr) - 1;
+        if (offsetOf(ptr) == last_) {                           // most recent block: grow/shrink in place
+            const size_t need = blockSize(size);
+            if (need > SIZE - last_) return fail();
+            header->size = size;
+            top_ = last_ + need;
+            if (top_ > peak_) peak_ = top_;
+            return ptr;
+        }
+        if (size <= header->size) {                             // shrinking an older block: keep it where it is
+            header->size = size;
+            return ptr;
+        }
+        void *moved = allocate(size);                           // growing an older block: copy it to the top
+        if (moved == nullptr) return nullptr;
+        memcpy(moved, ptr, header->size);
+        deallocate(ptr);
+        return moved;
+    }
+    // ------ Usage ------
+    [[nodiscard]] size_t used() const { return top_; }          // Bytes in use right now
+    [[nodiscard]] size_t peak() const { return peak_; }         // Most bytes ever in use
+    [[nodiscard]] uint32_t failures() const { return failures_; } // Allocations refused for lack of space
+    static constexpr size_t capacity() { return SIZE; }
+private:
+    struct alignas(std::max_align_t) Header {
+        size_t size;                                            // Bytes requested for the block
+    };
+    static constexpr size_t ALIGN = alignof(std::max_align_t);
+    static constexpr size_t NONE = SIZE_MAX;
+    static constexpr size_t blockSize(const size_t size) {
+        return sizeof(Header) + (size + ALIGN - 1) / ALIGN * ALIGN;
+    }
+    Header *headerAt(const size_t offset) { return reinterpret_cast<Header *>(buffer_ + offset); }
+    size_t offsetOf(const void *ptr) const {
+        return static_cast<size_t>(reinterpret_cast<const uint8_t *>(static_cast<const Header *>(ptr) - 1) - buffer_);
+    }
+    void *fail() {
+        failures_++;
+        return nullptr;
+    }
+    alignas(std::max_align_t) uint8_t buffer_[SIZE];
+    size_t top_;                                                // Offset of the first free byte
+    size_t last_;                                               // Offset of the most recent block (NONE if freed)
+    size_t live_;                                               // Blocks allocated and not yet freed
+    size_t peak_;
+    uint32_t failures_;
+};
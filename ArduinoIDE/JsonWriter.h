@@ -0,0 +1,107 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Append-only JSON text writer for messages whose shape is fixed at compile time (the streamed BATCH). Instead of
+ *  building a JsonDocument and serializing it, the caller writes the message in order: the literal parts are string
+ *  literals whose length is known at compile time (copied with one memcpy each), and the numbers go through an
+ *  integer-to-ASCII routine that emits two digits per step. Nothing is allocated and nothing is escaped, so only
+ *  use it for keys/values known not to need escaping.
+ *      >> The writer never writes past its buffer. If a message doesn't fit, overflowed() is set and finish() returns 0,
+ *         so a truncated message is never sent.
+ *      >> GET/SET replies have varied shapes and are rare; they keep going through outBuffer.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+class JsonWriter {
+public:
+    JsonWriter(char *buffer, const size_t capacity) : begin_(buffer), pos_(buffer), end_(buffer + capacity), overflowed_(false) {}
+    /* ------ Literal text, length taken from the array type ------ */
+    template <size_t N>
+    JsonWriter &raw(const char (&text)[N]) {
+        return append(text, N - 1);
+    }
+    JsonWriter &raw(const char c) {
+        return append(&c, 1);
+    }
+    /* ------ A quoted name known not to need escaping (identifiers, not user text) ------ */
+    JsonWriter &name(const char *text) {
+        raw('"');
+        append(text, strlen(text));
+        return raw('"');
+    }
+    /* ------ Numbers ------ */
+    JsonWriter &number(uint32_t v) {
+        char digits[10];
+        char *p = digits + sizeof(digits);
+        while (v >= 100) {
+            const uint32_t pair = (v % 100) * 2;
+            v /= 100;
+            *--p = PAIRS[pair + 1];
+            *--p = PAIRS[pair];
+        }
+        if (v >= 10) {
+            *--p = PAIRS[v * 2 + 1];
+            *--p = PAIRS[v * 2];
+        } else {
+            *--p = static_cast<char>('0' + v);
+        }
+        return append(p, static_cast<size_t>(digits + sizeof(digits) - p));
+    }
+    JsonWriter &number(const uint64_t v) {
+        if (v <= UINT32_MAX) return number(static_cast<uint32_t>(v)); // the common case: no 64-bit division
+        number(v / 1000000000u);                                // leading digits, then the last nine zero-padded
+        return padded9(static_cast<uint32_t>(v % 1000000000u));
+    }
+    JsonWriter &number(const int32_t v) {
+        if (v >= 0) return number(static_cast<uint32_t>(v));
+        raw('-');
+        return number(static_cast<uint32_t>(0u - static_cast<uint32_t>(v)));
+    }
+    JsonWriter &number(const uint16_t v) { return number(static_cast<uint32_t>(v)); }
+    JsonWriter &number(const uint8_t v) { return number(static_cast<uint32_t>(v)); }
+    /* ------ Result ------ */
+    [[nodiscard]] bool overflowed() const { return overflowed_; }
+    size_t finish() const {                                     // Bytes written, 0 if the message didn't fit
+        return overflowed_ ? 0 : static_cast<size_t>(pos_ - begin_);
+    }
+private:
+    static constexpr char PAIRS[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+    JsonWriter &append(const char *text, const size_t n) {
+        if (overflowed_ || n > static_cast<size_t>(end_ - pos_)) {
+            overflowed_ = true;
+            return *this;
+        }
+        memcpy(pos_, text, n);
+        pos_ += n;
+        return *this;
+    }
+    JsonWriter &padded9(uint32_t v) {                           // Exactly nine digits, zero-padded
+        char digits[9];
+        for (int i = 8; i >= 0; i--) {
+            digits[i] = static_cast<char>('0' + v % 10);
+            v /= 10;
+        }
+        return append(digits, sizeof(digits));
+    }
+    char *begin_;
+    char *pos_;
+    char *end_;
+    bool overflowed_;
+};
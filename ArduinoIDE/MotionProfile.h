@@ -0,0 +1,65 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Rest-to-rest motion planner for the servo. plan() works out, once per move, how long each phase of the move lasts;
+ *  position() then gives the setpoint at any time since the move started, so ServoController can sample it at its
+ *  fixed update rate and get sub-degree setpoints with no stair-steps.
+ *      >> S_CURVE is the 7-phase jerk-limited profile (jerk up, constant acceleration, jerk down, cruise, and the mirror
+ *         image to stop): acceleration ramps instead of switching on, so there is no velocity kink at either end.
+ *         TRAPEZOID is the same profile with the jerk phases removed (acceleration switches on and off).
+ *      >> When the move is too short to reach the velocity limit (or the acceleration limit), the peak is lowered so
+ *         the profile still ends exactly at the target; the limits are never exceeded.
+ *      >> Angles are in degrees and times in seconds as floats (the ESP32-S3 has a single-precision FPU). Planning
+ *         costs a square or cube root; position() is a short search over 7 phases and a cubic.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <cstdint>
+
+class MotionProfile {                       //  Class planning and sampling one move
+public:
+    //------------- Custom types
+    enum Shape {                                                    //  Velocity profile shapes
+        TRAPEZOID,                                                  //  Acceleration-limited (acceleration steps)
+        S_CURVE                                                     //  Jerk-limited (acceleration ramps)
+    };
+    struct Limits {                                                 //  Bounds the planner keeps to (all > 0)
+        float velocity;                                             //  º/s
+        float acceleration;                                         //  º/s²
+        float jerk;                                                 //  º/s³, S_CURVE only
+    };
+    //------------- Constructor
+    MotionProfile();
+    //------------- Instance methods
+    bool plan(                                                      //  Plan a move. False (and an empty move) if a limit isn't > 0.
+        float from,                                                     //  Start angle (º)
+        float to,                                                       //  Target angle (º)
+        const Limits &limits,                                           //  Velocity/acceleration/jerk bounds
+        Shape shape);                                                   //  TRAPEZOID or S_CURVE
+    [[nodiscard]] float position(                                   //  Setpoint (º) at a time into the move; the target once it's over
+        uint64_t elapsedUs) const;                                      //  Time since the move started (µs)
+    [[nodiscard]] uint64_t getDuration() const                      //  Length of the move (µs)
+        { return duration_; }
+    [[nodiscard]] float getPeakVelocity() const                     //  Cruise velocity actually reached (º/s)
+        { return peak_; }
+private:
+    //------------- Private types
+    struct Phase {                                                  //  One phase, with the state it starts in (along the move)
+        float duration;                                             //  s
+        float jerk;                                                 //  º/s³ held through the phase
+        float position;                                             //  º from the start
+        float velocity;                                             //  º/s
+        float acceleration;                                         //  º/s², set (not integrated) so TRAPEZOID can step it
+    };
+    static constexpr uint8_t PHASES = 7;
+    //------------- Private instance fields
+    Phase phases_[PHASES];
+    float from_;                                                    //  Start angle (º)
+    float distance_;                                                //  |to - from| (º)
+    float direction_;                                               //  +1 or -1
+    float peak_;                                                    //  Cruise velocity (º/s)
+    uint64_t duration_;                                             //  µs
+};
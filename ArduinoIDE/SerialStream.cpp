@@ -0,0 +1,139 @@
+#include "SerialStream.h"
+#include <atomic>
+#include <cstring>
+#include "Hal.h"
+#include "MpscRing.h"
+
+namespace sr {
+    namespace {
+        struct Record {                                         // One queued piece of a line, or a deferred record
+            uint8_t length;
+            char text[LINE_SIZE];
+        };
+        struct Line {                                           // A task's line so far (never longer than a record)
+            uint8_t length;
+            char text[LINE_SIZE];
+        };
+        struct Limit {                                          // Lines per second at one level
+            std::atomic<uint32_t> rate;                         // Cap (0 = none)
+            std::atomic<uint32_t> windowStart;                  // ms the current one-second window began
+            std::atomic<uint32_t> count;                        // Lines offered in the current window
+            std::atomic<uint32_t> drops;                        // Lines dropped since boot
+        };
+        thread_local Line line;                                 // Every task (and timer callback task) has its own
+        MpscRing<Record, RING_SLOTS> ring;
+        hal::Event wake;                                        // Signalled whenever a record is queued
+        std::atomic<bool> started{false};                       // Whether the writer task owns the ring
+        Limit limits[LEVELS] = {
+            {{DEFAULT_RATE[0]}, {0}, {0}, {0}},
+            {{DEFAULT_RATE[1]}, {0}, {0}, {0}},
+            {{DEFAULT_RATE[2]}, {0}, {0}, {0}},
+            {{DEFAULT_RATE[3]}, {0}, {0}, {0}},
+            {{DEFAULT_RATE[4]}, {0}, {0}, {0}},
+        };
+        Print *output = &Serial;                                // Where drain() writes (consumer only)
+        uint32_t reported = 0;                                  // Drops already reported (consumer only)
+
+        Limit &limitOf(const Level level) { return limits[static_cast<size_t>(level)]; }
+        /* ------ Whether the rate cap lets one more record through ------
+         * Windows restart at most once a second; the task that wins the compare-and-swap resets the count. Counting
+         * is approximate while two tasks cross a window boundary, which only ever lets a line or two extra through.
+         */
+        bool admit(Limit &limit) {
+            const uint32_t rate = limit.rate.load(std::memory_order_relaxed);
+            if (rate == 0) return true;
+            const auto now = static_cast<uint32_t>(hal::micros() / 1000);
+            if (uint32_t start = limit.windowStart.load(std::memory_order_relaxed);
+                now - start >= 1000 && limit.windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+                limit.count.store(0, std::memory_order_relaxed);
+            }
+            return limit.count.fetch_add(1, std::memory_order_relaxed) < rate;
+        }
+        /* ------ Queue one record ------ */
+        void commit(const Level level, const uint8_t *bytes, const size_t size) {
+            Limit &limit = limitOf(level);
+            Record record;
+            record.length = static_cast<uint8_t>(size);
+            memcpy(record.text, bytes, size);
+            if (!admit(limit) || !ring.push(record)) {
+                limit.drops.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            if (started.load(std::memory_order_acquire)) wake.signal();
+            else drain();                                       // no writer yet: this task writes it
+        }
+        void commitLine(const Level level) {                    // Queue the calling task's line and empty it
+            commit(level, reinterpret_cast<const uint8_t *>(line.text), line.length);
+            line.length = 0;
+        }
+#ifdef ARDUINO
+        void writerTask(void *) {
+            wake.attach();
+            for (;;) {
+                drain();                                        // anything queued before attach() included
+                wake.wait(hal::FOREVER);
+            }
+        }
+#endif
+    } // namespace
+
+    /* ------ Start the writer task ------
+     * started is set first so no line is written directly while the task exists; if the task can't be created the
+     * log stays synchronous rather than going quiet.
+     */
+    void begin() {
+#ifdef ARDUINO
+        if (started.exchange(true, std::memory_order_acq_rel)) return;
+        if (xTaskCreatePinnedToCore(writerTask, "log", WRITER_STACK, nullptr, WRITER_PRIORITY, nullptr, tskNO_AFFINITY) != pdPASS) {
+            started.store(false, std::memory_order_release);
+        }
+#endif
+    }
+    /* ------ Write every queued record, then report any lines lost since the last report ------
+     * Only one task may drain: the writer once begin() has run, otherwise whichever task ends a line.
+     */
+    void drain() {
+        Record record;
+        while (ring.pop(record)) output->write(reinterpret_cast<const uint8_t *>(record.text), record.length);
+        if (const uint32_t total = dropped(); total != reported) {
+            output->print("[log] ");
+            output->print(total - reported);
+            output->print(" lines dropped");
+            output->println();
+            reported = total;
+        }
+    }
+    void setOutput(Print &to) {                                 // Call from the task that drains
+        output = &to;
+    }
+    void setRateLimit(const Level level, const uint32_t linesPerSecond) {
+        limitOf(level).rate.store(linesPerSecond, std::memory_order_relaxed);
+    }
+    uint32_t getRateLimit(const Level level) { return limitOf(level).rate.load(std::memory_order_relaxed); }
+    uint32_t dropped(const Level level) { return limitOf(level).drops.load(std::memory_order_relaxed); }
+    uint32_t dropped() {
+        uint32_t total = 0;
+        for (const Limit &limit : limits) total += limit.drops.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    namespace detail {
+        /* Lines longer than a record are queued a record at a time; each record counts against the rate cap. */
+        void append(const Level level, const uint8_t *bytes, size_t size) {
+            while (size > 0) {
+                if (line.length == LINE_SIZE) commitLine(level);
+                const size_t n = size < LINE_SIZE - line.length ? size : LINE_SIZE - line.length;
+                memcpy(line.text + line.length, bytes, n);
+                line.length += n;
+                bytes += n;
+                size -= n;
+            }
+        }
+        void endLine(const Level level) {
+            if (line.length > 0) commitLine(level);
+        }
+        void queue(const Level level, const uint8_t *bytes, const size_t size) {
+            commit(level, bytes, size);
+        }
+    } // namespace detail
+} // namespace sr
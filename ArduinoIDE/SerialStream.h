@@ -8,9 +8,32 @@
  *    It is overloaded similarly to std::cout << std::endl
  *    with << operator buffering the right-side value to the Print stream, separating types.
  *    Handy tool for continuous calls to Serial, and event provides a debugging option, where,
- *    if #PRINT_DEBUG is defined (in a header scoped within the scope of the project), calls to
+ *    if PRINT_DEBUG is defined for the whole build (a build flag, see LEVELS), calls to
  *    sr::debug will print verbose debugging statements. 
  *    
+ *    Nothing is written to Serial by the task doing the logging. Each task builds its line in its own buffer, and
+ *    sr::endl queues the finished line in a lock-free ring (see 'MpscRing.h') that a low-priority writer task drains
+ *    to Serial. A stalled USB CDC port only stalls the writer, never sampling or servo stepping.
+ *        >> Lines are queued in records of up to LINE_SIZE bytes; longer lines take several.
+ *        >> Each level is capped at a number of lines per second. Lines over the cap, or arriving while the ring is
+ *           full, are dropped and counted (dropped()), and the writer reports how many were lost once it catches up.
+ *        >> Until begin() starts the writer (and always off the board), lines are written as soon as they end.
+ *
+ *    LEVELS
+ *    sr::trace, sr::debug, sr::info (sr::out), sr::warn and sr::error. Levels below SR_LEVEL are decided at compile
+ *    time: their stream is a NullStream whose operators are empty, so a statement on it compiles to nothing as long as
+ *    its arguments have no side effects. SR_LOG(LEVEL) << ... also skips evaluating the arguments.
+ *        >> SR_LEVEL is a build flag (0 TRACE, 1 DEBUG, 2 INFO, 3 WARN, 4 ERROR, 5 off); without one it is INFO, or
+ *           DEBUG if PRINT_DEBUG or DEBUG_ON is defined for the whole build.
+ *
+ *    DEFERRED FORMATTING
+ *    SR_DEFER(LEVEL, "format", args...) queues a binary record instead of text: DEFERRED, the level, a 32-bit hash
+ *    of the format string, the argument count and each argument as 4 raw little-endian bytes. Neither the format
+ *    string nor any formatting code ends up on the board. 'tools/logdecode.py' finds the format strings in the
+ *    sources and prints the records as text again, passing ordinary lines through.
+ *        >> Arguments must be integers, enums or floats of at most 4 bytes, at most MAX_DEFERRED_ARGS of them. The
+ *           format only uses printf conversions (%d %i %u %x %X %c %f %e %g and %%) so the decoder can apply it.
+ *
  *    Usage ex:
  *      sr::out << "Hello world" << sr::endl;
  *----------------------------------------------------------------------------------------------------------------------*/
@@ -19,21 +42,108 @@
 #include <Arduino.h>                                            // For Print class */
 #include <Print.h>                                              // brings in Arduino’s Print & __FlashStringHelper
 #include <HardwareSerial.h>                                     // for Serial
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#ifndef SR_LEVEL
+    #if defined(PRINT_DEBUG) || defined(DEBUG_ON)
+        #define SR_LEVEL 1
+    #else
+        #define SR_LEVEL 2
+    #endif
+#endif
 /*
  * Encapsulation within 'sr' (serial) namespace.
  */
 namespace sr {
-    struct Stream {                                             // Small wrapper for any Print-derived object.
-        Print& _p;                                              // Instance of the Print object
-        explicit Stream(Print& p): _p(p) {}                     /* Explicit constructor requiring reference to a Print-derived object,
-                                                                   using initializer-list syntax to instantiate public Print reference.  */
+    enum class Level : uint8_t { TRACE, DEBUG, INFO, WARN, ERROR }; // Index into the per-level rate limits
+    constexpr size_t LEVELS = 5;
+    constexpr int THRESHOLD = SR_LEVEL;                         // Lowest level compiled in
+    constexpr size_t LINE_SIZE = 96;                            // Bytes per queued record
+    constexpr size_t RING_SLOTS = 64;                           // Records waiting for the writer
+    constexpr uint32_t DEFAULT_RATE[LEVELS] = {50, 50, 100, 100, 0}; // Lines per second per level (0 = no cap)
+    constexpr int WRITER_PRIORITY = 1;                          // Just above idle
+    constexpr uint32_t WRITER_STACK = 3072;                     // Bytes
+    constexpr uint8_t DEFERRED = 0x1E;                          // First byte of a deferred record (ASCII RS)
+    constexpr size_t MAX_DEFERRED_ARGS = 8;
+
+    constexpr bool enabled(const Level level) { return static_cast<int>(level) >= THRESHOLD; }
+
+    void begin();                                               // Start the writer task (board only)
+    void drain();                                               // Write every queued record to the output
+    void setOutput(Print &to);                                  // Where drained records go (Serial by default)
+    void setRateLimit(Level level, uint32_t linesPerSecond);    // 0 lifts the cap
+    uint32_t getRateLimit(Level level);
+    uint32_t dropped(Level level);                              // Lines dropped since boot at one level
+    uint32_t dropped();                                         // ... at every level
+
+    namespace detail {
+        void append(Level level, const uint8_t *bytes, size_t size); // Add to the calling task's line
+        void endLine(Level level);                              // Queue the calling task's line
+        void queue(Level level, const uint8_t *bytes, size_t size); // Queue a whole record (<= LINE_SIZE)
+        class LineWriter : public Print {                       // Print's formatting, into the calling task's line
+        public:
+            explicit LineWriter(const Level level) : level_(level) {}
+            size_t write(const uint8_t c) override { append(level_, &c, 1); return 1; }
+            size_t write(const uint8_t *buffer, const size_t size) override { append(level_, buffer, size); return size; }
+            using Print::write;
+        private:
+            const Level level_;
+        };
+        template <typename T>
+        uint32_t raw(const T value) {                           // A deferred argument's 4 bytes
+            static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "SR_DEFER arguments must be numbers");
+            static_assert(sizeof(T) <= 4, "SR_DEFER arguments must fit 4 bytes; split 64-bit values");
+            if constexpr (std::is_floating_point_v<T>) {
+                uint32_t bits;
+                memcpy(&bits, &value, sizeof(bits));
+                return bits;
+            } else {
+                return static_cast<uint32_t>(value);            // sign-extended, so %d decodes negatives
+            }
+        }
+    } // namespace detail
+
+    /* ------ 32-bit FNV-1a hash of a format string: a deferred record's format id ------ */
+    constexpr uint32_t formatId(const char *format) {
+        uint32_t hash = 2166136261u;
+        while (*format != '\0') hash = (hash ^ static_cast<uint8_t>(*format++)) * 16777619u;
+        return hash;
+    }
+    /* ------ Queue a deferred record (use SR_DEFER, which hashes the format at compile time) ------ */
+    template <typename... Args>
+    void defer(const Level level, const uint32_t id, const Args... args) {
+        static_assert(sizeof...(Args) <= MAX_DEFERRED_ARGS, "Too many SR_DEFER arguments");
+        uint8_t record[7 + 4 * sizeof...(Args)] = {DEFERRED, static_cast<uint8_t>(level),
+            static_cast<uint8_t>(id), static_cast<uint8_t>(id >> 8), static_cast<uint8_t>(id >> 16),
+            static_cast<uint8_t>(id >> 24), static_cast<uint8_t>(sizeof...(Args))};
+        size_t at = 7;
+        for (const uint32_t value : {detail::raw(args)...}) {
+            for (int shift = 0; shift < 32; shift += 8) record[at++] = static_cast<uint8_t>(value >> shift);
+        }
+        detail::queue(level, record, at);
+    }
+    template <>
+    inline void defer<>(const Level level, const uint32_t id) {
+        const uint8_t record[7] = {DEFERRED, static_cast<uint8_t>(level), static_cast<uint8_t>(id),
+            static_cast<uint8_t>(id >> 8), static_cast<uint8_t>(id >> 16), static_cast<uint8_t>(id >> 24), 0};
+        detail::queue(level, record, sizeof(record));
+    }
+
+    struct Stream {                                             // Line-buffered stream at one level.
+        const Level level;                                      // Rate limit the stream's lines count against
+        explicit constexpr Stream(const Level l): level(l) {}
         template <typename T>                                   // Generic 'print this value' overload
         Stream& operator<<(const T& v) {
-            _p.print(v);
+            detail::LineWriter line(level);
+            line.print(v);
             return *this;
         }
         Stream& operator<<(const __FlashStringHelper* v) {     // Overloaded '<<' operator for flash strings (F() macro)
-            _p.print(v);
+            detail::LineWriter line(level);
+            line.print(v);
             return *this;
         }
         using Manip = Stream& (*)(Stream&);                    // Type alias for stream manipulators (functions taking/returning Stream&)
@@ -41,24 +151,39 @@ namespace sr {
             return m(*this);
         }
     }; // end struct Stream
-    inline Stream out{ Serial };                            // Single instance bound to Serial.
-    inline Stream& endl(Stream& s) {                           // endl manipulator declaration
-        s._p.println();
+    inline Stream& endl(Stream& s) {                           // endl manipulator: end the line and queue it
+        detail::LineWriter line(s.level);
+        line.println();
+        detail::endLine(s.level);
         return s;
     }
-    // Optional sr::debug to print verbose statements
-    #ifdef DEBUG_ON
-        inline Stream& debug{ Serial };
-    #else
-    struct NullStream {                                       // Define a null-sink
+    struct NullStream {                                       // Define a null-sink for levels compiled out
+        explicit constexpr NullStream(Level) {}
         template <typename T>
-        NullStream& operator<<(const T&) {                    // Swallow printable types
+        constexpr NullStream& operator<<(const T&) {          // Swallow printable types
             return *this;
         }
-        NullStream& operator<<(Stream::Manip) {               // Swallow stream manips
+        constexpr NullStream& operator<<(Stream::Manip) {     // Swallow stream manips
             return *this;
         }
     };
-    inline NullStream debug;                                  // No alias to Stream&, does nothing.
-#endif
+    template <Level L>
+    using Logger = std::conditional_t<enabled(L), Stream, NullStream>;
+    template <Level L>
+    inline Logger<L> logger{ L };                             // One stream per level
+    inline auto& trace = logger<Level::TRACE>;
+    inline auto& debug = logger<Level::DEBUG>;
+    inline auto& info = logger<Level::INFO>;
+    inline auto& warn = logger<Level::WARN>;
+    inline auto& error = logger<Level::ERROR>;
+    inline auto& out = info;                                  // Ordinary messages, as before levels existed.
 } // namespace sr
+
+/* Statement-level forms that don't evaluate anything when LEVEL is compiled out, e.g.
+ *     SR_LOG(DEBUG) << "pos " << pos_ << sr::endl;
+ *     SR_DEFER(DEBUG, "pos %d, duty %u", pos_, duty_);
+ */
+#define SR_LOG(LEVEL) if constexpr (!sr::enabled(sr::Level::LEVEL)) {} else sr::logger<sr::Level::LEVEL>
+#define SR_DEFER(LEVEL, FORMAT, ...)                                                                                   \
+    if constexpr (!sr::enabled(sr::Level::LEVEL)) {} else                                                              \
+        sr::defer(sr::Level::LEVEL, std::integral_constant<uint32_t, sr::formatId(FORMAT)>::value, ##__VA_ARGS__)
@@ -1,28 +1,37 @@
 #include "ServoController.h"
+#include <cmath>
 
 
 uint8_t ServoController::channelCount = 0;
-portMUX_TYPE ServoController::mux = portMUX_INITIALIZER_UNLOCKED;
 void ServoController::timerCB(void *arg) {
     const auto instance = static_cast<ServoController*>(arg);
-    portENTER_CRITICAL(&mux);
-    instance->tick_ = true;
-    portEXIT_CRITICAL(&mux);
+    if (instance->playing_.load(std::memory_order_acquire)) {
+        instance->playNext();
+        return;
+    }
+    if (instance->ticks_.fetch_add(1, std::memory_order_release) > 0) { // loop() hasn't taken the last one yet
+        instance->missedTicks_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (instance->wake_ != nullptr) instance->wake_->signal();
 }
 void ServoController::fallbackTimerCB(void *arg) {
-    if (const auto self = static_cast<ServoController*>(arg); !esp_timer_is_active(self->timer_)) {
+    if (const auto self = static_cast<ServoController*>(arg); !hal::timerActive(self->timer_)) {
         if (self->motion_ != INVALID && self->motion_ != ONE_SHOT) {
-            if (const esp_err_t err = esp_timer_start_periodic(self->timer_, self->delayUs_); err != ESP_OK) {
-                sr::out << "Failed to restart servo timer: " << esp_err_to_name(err) << sr::endl;
+            if (const hal::Error err = hal::timerStartPeriodic(self->timer_, self->delayUs_); err != hal::OK) {
+                sr::error << "Failed to restart servo timer: " << hal::errorName(err) << sr::endl;
             }
         }
     }
 }
 ServoController::ServoController(uint8_t pin, unsigned int maxAngle) :
+    angleNotify_(nullptr),
+    ticks_(0),
+    wake_(nullptr),
     pin_(pin),
+    channel_(channelCount),
+    duty_(0),
     maxAngle_(maxAngle),
-    timer_(nullptr),
-    fallbackTimer_(nullptr),
+    motion_(LOOP),
     pos_(0),
     delayUs_(100000),
     pwmMin_(500),
@@ -30,53 +39,66 @@ ServoController::ServoController(uint8_t pin, unsigned int maxAngle) :
     startAngle_(0),
     stopAngle_(270),
     angleStep_(1),
-    fallbackTimerArgs_({
-        .callback = fallbackTimerCB,
-        .arg = this,
-        .dispatch_method = ESP_TIMER_TASK,
-        .name = "fallback",
-        .skip_unhandled_events = false
-    }),
-    timerArgs_({
-        .callback = timerCB,
-        .arg = this,
-        .dispatch_method = ESP_TIMER_TASK,
-        .name = "servo",
-        .skip_unhandled_events = false
-    }),
-    tick_(false), angleNotify_(nullptr),
-    motion_(LOOP),
+    setpoint_(0),
+    profile_(STEP),
+    maxVelocity_(90),                                           // a 90º flexion in about 1.25 s (S_CURVE)
+    maxAccel_(360),
+    maxJerk_(3600),
+    planned_(false),
+    legTicks_(0),
+    playback_(false),
+    playing_(false),
+    waypoints_{},
+    waypointCount_(0),
+    cycleStart_(0),
+    cursor_(0),
+    writing_(false),
+    timer_(nullptr),
+    fallbackTimer_(nullptr),
     fallbackDelay(3000000)
 {
-    channelCount++;
+    channelCount++;                                             // next servo gets the next channel
 }
 
 
 ServoController::~ServoController() {
-    esp_timer_stop(timer_);
-    esp_timer_stop(fallbackTimer_);
-    esp_timer_delete(timer_);
-    esp_timer_delete(fallbackTimer_);
+    hal::timerStop(timer_);
+    hal::timerStop(fallbackTimer_);
+    hal::timerDelete(timer_);
+    hal::timerDelete(fallbackTimer_);
+    hal::pwmDetach(pin_);
+    if (channel_ + 1 == channelCount) channelCount--;          // the newest servo's channel can be handed out again
 }
 void ServoController::setup() {
-    tick_ = false;
-    const auto error = esp_timer_create(&timerArgs_, &timer_);
-    if (error != ESP_OK) {
-        sr::out << "Failed to create timer: " << error << sr::endl << "Throwing std::runtime_error." << sr::endl;
+    ticks_.store(0, std::memory_order_relaxed);
+    if (hal::pwmSetup(channel_, PWM_FREQUENCY, PWM_BITS) == 0) {
+        sr::error << "Failed to set up PWM channel " << channel_ << sr::endl << "Throwing std::runtime_error." << sr::endl;
+        throw std::runtime_error("Failed to set up PWM channel");
+    }
+    hal::pwmAttach(pin_, channel_);
+    const auto error = hal::timerCreate(timerCB, this, "servo", &timer_);
+    if (error != hal::OK) {
+        sr::error << "Failed to create timer: " << error << sr::endl << "Throwing std::runtime_error." << sr::endl;
         throw std::runtime_error("Failed to create timer");
     }
-    const auto error2 = esp_timer_create(&fallbackTimerArgs_, &fallbackTimer_);
-    if (error2 != ESP_OK) {
-        sr::out << "Failed to create fallback timer: " << error2 << sr::endl << "Throwing std::runtime_error." << sr::endl;
+    const auto error2 = hal::timerCreate(fallbackTimerCB, this, "fallback", &fallbackTimer_);
+    if (error2 != hal::OK) {
+        sr::error << "Failed to create fallback timer: " << error2 << sr::endl << "Throwing std::runtime_error." << sr::endl;
         throw std::runtime_error("Failed to create fallback timer");
     }
 }
 void ServoController::loop() {
-    portENTER_CRITICAL(&mux);
-    bool run = tick_;
-    tick_ = false;
-    portEXIT_CRITICAL(&mux);
-    if (!run) return;
+    if (playing_.load(std::memory_order_acquire)) {
+        followPlayback();
+        return;
+    }
+    if (ticks_.exchange(0, std::memory_order_acquire) == 0) return; // one update however many ticks came
+    if (profile_ != STEP) {
+        followProfile();
+        updateDuty();
+        if (angleNotify_) angleNotify_(pos_);
+        return;
+    }
     if (angleStep_ == 0) {
         sr::debug << F("Angle-step was set to 0. Setting to 1 and disabling motion.");
         angleStep_ = 1;
@@ -112,7 +134,7 @@ void ServoController::loop() {
                         disableMotion();
                         sr::debug << F("Starting fallback timer: \n\t\tcurrent pos = ") << pos_ << F(", \n\tpos after increment = ") << newPos
                         << F(", \n\t\t\t stopAngle_ = ") << stopAngle_ << sr::endl;
-                        esp_timer_start_once(fallbackTimer_, fallbackDelay);
+                        hal::timerStartOnce(fallbackTimer_, fallbackDelay);
                     } else {
                         pos_ = newPos;
                     }
@@ -135,7 +157,7 @@ void ServoController::loop() {
                         disableMotion();
                         sr::debug << F("Starting fallback timer: \n\t\tcurrent pos = ") << pos_ << F(", \n\tpos after decrement = ") << newPos
                         << F(", \n\t\t\t startAngle_ = ") << startAngle_ << sr::endl;
-                        esp_timer_start_once(fallbackTimer_, fallbackDelay);
+                        hal::timerStartOnce(fallbackTimer_, fallbackDelay);
                     } else {
                         pos_ = newPos;
                     }
@@ -192,8 +214,8 @@ void ServoController::loop() {
                 } else {
                     // Check if sum is > stopAngle,
                     if (const int newPos = pos_ + angleStep_; newPos > stopAngle_) {
-                        // If so, start the fallback timer to let the servo go back to startAngle.
-                        pos_ = startAngle_;
+                        // If so, stop there; a one-shot doesn't return to the start angle.
+                        pos_ = stopAngle_;
                         disableMotion();
                         sr::debug << "Stopping timer. Motion finished. \n\tCurrent position: " << pos_ << sr::endl
                         << "\tStop-angle: " << stopAngle_ << sr::endl;
@@ -227,15 +249,207 @@ void ServoController::loop() {
         } break;
         default: disableMotion(); break;
     }
+    setpoint_ = pos_ * MILLI;
     updateDuty();
     if (angleNotify_) angleNotify_(pos_);
 }
+/* ------ Compile the motion into waypoints_ ------
+ * The leg from the current setpoint to the end the motion heads for first (as planLeg() picks it), and for a SWEEP the
+ * round trip between the two ends after it, which the timer repeats. Only called with the timer stopped.
+ */
+bool ServoController::compileTrajectory() {
+    const int first = motion_ == SWEEP && angleStep_ < 0 ? startAngle_ : stopAngle_;
+    size_t count = 0;
+    if (!compileLeg(setpoint_, first * MILLI, count)) return false;
+    cycleStart_ = count;                                        // == count at the end unless SWEEP adds a cycle
+    if (motion_ == SWEEP) {
+        const int second = first == stopAngle_ ? startAngle_ : stopAngle_;
+        if (!compileLeg(first * MILLI, second * MILLI, count) || !compileLeg(second * MILLI, first * MILLI, count)) return false;
+    }
+    waypointCount_ = count;
+    cursor_.store(0, std::memory_order_relaxed);
+    SR_DEFER(DEBUG, "Compiled %u waypoints (%u ms)", static_cast<uint32_t>(count), static_cast<uint32_t>(count * delayUs_ / 1000));
+    return true;
+}
+bool ServoController::compileLeg(const MilliDegrees from, const MilliDegrees to, size_t &count) {
+    MotionProfile leg;
+    const MotionProfile::Limits limits{static_cast<float>(maxVelocity_), static_cast<float>(maxAccel_), static_cast<float>(maxJerk_)};
+    if (!leg.plan(static_cast<float>(from) / MILLI, static_cast<float>(to) / MILLI, limits,
+                  profile_ == S_CURVE ? MotionProfile::S_CURVE : MotionProfile::TRAPEZOID)) {
+        return false;
+    }
+    for (uint32_t ticks = 1; ; ticks++) {                       // same sampling as followProfile()
+        if (count == MAX_WAYPOINTS) {
+            sr::warn << "Trajectory needs more than " << MAX_WAYPOINTS << " updates; updating from loop() instead." << sr::endl;
+            return false;
+        }
+        const uint64_t elapsed = static_cast<uint64_t>(ticks) * delayUs_;
+        const auto setpoint = static_cast<MilliDegrees>(std::lround(leg.position(elapsed) * MILLI));
+        waypoints_[count++] = {setpoint, static_cast<uint16_t>(dutyFor(setpoint))};
+        if (elapsed >= leg.getDuration()) return true;
+    }
+}
+/* ------ Timer context: write the next waypoint ------
+ * Nothing but an index and an LEDC write. timerStop() doesn't wait for a callback already running (the timer task is
+ * on the other core), so the callback raises writing_ before it rechecks playing_, and disableMotion() clears playing_
+ * before it waits for writing_ to drop: either this sees playing_ cleared and writes nothing, or disableMotion() waits
+ * until it's done. Once disableMotion() returns, waypoints_, cursor_ and the duty are loop()'s alone.
+ */
+void ServoController::playNext() {
+    writing_.store(true, std::memory_order_seq_cst);
+    if (playing_.load(std::memory_order_seq_cst)) {
+        size_t next = cursor_.load(std::memory_order_relaxed);
+        if (next == waypointCount_ && cycleStart_ != waypointCount_) next = cycleStart_;
+        if (next != waypointCount_) {                           // else finished; loop() stops the timer
+            hal::pwmWrite(channel_, waypoints_[next].duty);
+            cursor_.store(next + 1, std::memory_order_release);
+            if (wake_ != nullptr) wake_->signal();              // loop() reports the position
+        }
+    }
+    writing_.store(false, std::memory_order_release);
+}
+/* ------ loop() context while playing: catch up with the timer ------
+ * One notification per call for however many waypoints played since the last one, and only if the whole-degree
+ * position changed. At the end of a trajectory, LOOP and ONE_SHOT finish the way followProfile() does.
+ */
+void ServoController::followPlayback() {
+    const size_t played = cursor_.load(std::memory_order_acquire);
+    if (played == 0) return;
+    const Waypoint &waypoint = waypoints_[played - 1];
+    setpoint_ = waypoint.setpoint;
+    duty_ = waypoint.duty;
+    if (const int pos = static_cast<int>((setpoint_ + MILLI / 2) / MILLI); pos != pos_) {
+        pos_ = pos;
+        if (angleNotify_) angleNotify_(pos_);
+    }
+    if (played != waypointCount_ || cycleStart_ != waypointCount_) return;
+    disableMotion();
+    if (motion_ == LOOP) {
+        pos_ = startAngle_;                                     // back to the start at full speed, as in STEP
+        setpoint_ = pos_ * MILLI;
+        updateDuty();
+        if (angleNotify_) angleNotify_(pos_);
+        playing_.store(compileTrajectory(), std::memory_order_release); // the fallback timer restarts it as it was
+        sr::debug << F("Starting fallback timer.") << sr::endl;
+        hal::timerStartOnce(fallbackTimer_, fallbackDelay);
+    } else {
+        SR_DEFER(DEBUG, "Reached stopAngle. Current position: %d", pos_);
+    }
+}
+/* ------ Plan the next leg ------
+ * LOOP and ONE_SHOT head for the stop angle. SWEEP heads for the end ANGLE_STEP's sign points at, as in STEP, and
+ * flips the sign at each end. Returns false if the limits are unusable.
+ */
+bool ServoController::planLeg() {
+    const int target = motion_ == SWEEP && angleStep_ < 0 ? startAngle_ : stopAngle_;
+    const float from = static_cast<float>(setpoint_) / MILLI;
+    const MotionProfile::Limits limits{static_cast<float>(maxVelocity_), static_cast<float>(maxAccel_), static_cast<float>(maxJerk_)};
+    if (!leg_.plan(from, static_cast<float>(target), limits, profile_ == S_CURVE ? MotionProfile::S_CURVE : MotionProfile::TRAPEZOID)) {
+        sr::warn << "Motion limits must be > 0. Disabling servo..." << sr::endl;
+        return false;
+    }
+    legTicks_ = 0;
+    planned_ = true;
+    sr::debug << "Planned " << profileString(profile_) << " leg to " << target << "º: " << leg_.getDuration()
+              << " µs, peak " << leg_.getPeakVelocity() << " º/s" << sr::endl;
+    return true;
+}
+/* ------ One update of a profiled leg ------
+ * Time into the leg is counted in updates (legTicks_ × TIME_DELAY), not read from the clock, so a late tick sends the
+ * setpoint it was due rather than skipping ahead.
+ */
+void ServoController::followProfile() {
+    if (motion_ == INVALID) {
+        disableMotion();
+        return;
+    }
+    if (!planned_ && !planLeg()) {
+        disableMotion();
+        return;
+    }
+    legTicks_++;
+    const uint64_t elapsed = static_cast<uint64_t>(legTicks_) * delayUs_;
+    setpoint_ = static_cast<MilliDegrees>(std::lround(leg_.position(elapsed) * MILLI));
+    pos_ = static_cast<int>((setpoint_ + MILLI / 2) / MILLI);
+    if (elapsed < leg_.getDuration()) return;
+    planned_ = false;                                           // leg finished
+    legTicks_ = 0;
+    switch (motion_) {
+        case LOOP: {
+            pos_ = startAngle_;                                 // back to the start at full speed, as in STEP
+            setpoint_ = pos_ * MILLI;
+            disableMotion();
+            sr::debug << F("Starting fallback timer.") << sr::endl;
+            hal::timerStartOnce(fallbackTimer_, fallbackDelay);
+        } break;
+        case SWEEP: {
+            angleStep_ *= -1;                                   // at rest; the next update plans the way back
+            sr::debug << F("Switching direction") << sr::endl;
+        } break;
+        case ONE_SHOT: {
+            disableMotion();
+            SR_DEFER(DEBUG, "Reached stopAngle. Current position: %d", pos_);
+        } break;
+        default: disableMotion(); break;
+    }
+}
+void ServoController::setProfile(const Profile profile) {
+    if (profile == INVALID_PROFILE) {
+        sr::warn << "Invalid motion profile." << sr::endl;
+        return;
+    }
+    const bool wasRunning = hal::timerActive(timer_);
+    if (wasRunning) disableMotion();
+    profile_ = profile;
+    sr::out << "new motion profile: " << profileString(profile_) << sr::endl;
+    if (wasRunning) enableMotion();
+}
+void ServoController::setPlayback(const bool playback) {
+    const bool wasRunning = hal::timerActive(timer_);
+    if (wasRunning) disableMotion();
+    playback_ = playback;
+    sr::out << "new playback: " << (playback_ ? "ON" : "OFF") << sr::endl;
+    if (wasRunning) enableMotion();
+}
+void ServoController::setMaxVelocity(const unsigned int velocity) {
+    if (velocity == 0) {
+        sr::warn << "max velocity must be > 0." << sr::endl;
+        return;
+    }
+    const bool wasRunning = hal::timerActive(timer_);
+    if (wasRunning) disableMotion();
+    maxVelocity_ = velocity;
+    sr::out << "new max velocity: " << maxVelocity_ << " º/s" << sr::endl;
+    if (wasRunning) enableMotion();
+}
+void ServoController::setMaxAccel(const unsigned int accel) {
+    if (accel == 0) {
+        sr::warn << "max acceleration must be > 0." << sr::endl;
+        return;
+    }
+    const bool wasRunning = hal::timerActive(timer_);
+    if (wasRunning) disableMotion();
+    maxAccel_ = accel;
+    sr::out << "new max acceleration: " << maxAccel_ << " º/s²" << sr::endl;
+    if (wasRunning) enableMotion();
+}
+void ServoController::setMaxJerk(const unsigned int jerk) {
+    if (jerk == 0) {
+        sr::warn << "max jerk must be > 0." << sr::endl;
+        return;
+    }
+    const bool wasRunning = hal::timerActive(timer_);
+    if (wasRunning) disableMotion();
+    maxJerk_ = jerk;
+    sr::out << "new max jerk: " << maxJerk_ << " º/s³" << sr::endl;
+    if (wasRunning) enableMotion();
+}
 void ServoController::setMaxPWM(const unsigned long m) {
     if (m <= pwmMin_) {
-        sr::out << "new max PWM value cannot be <= existing PWM value." << sr::endl;
+        sr::warn << "new max PWM value cannot be <= existing PWM value." << sr::endl;
         return;
     }
-    const bool wasRunning = esp_timer_is_active(timer_);
+    const bool wasRunning = hal::timerActive(timer_);
     if (wasRunning) disableMotion();
     pwmMax_ = m;
     sr::out << "new max PWM value: " << pwmMax_ << sr::endl;
@@ -243,10 +457,10 @@ void ServoController::setMaxPWM(const unsigned long m) {
 }
 void ServoController::setMinPWM(const unsigned long m) {
     if (m >= pwmMax_) {
-        sr::out << "new min PWM value cannot be >= existing PWM value." << sr::endl;
+        sr::warn << "new min PWM value cannot be >= existing PWM value." << sr::endl;
         return;
     }
-    const bool wasRunning = esp_timer_is_active(timer_);
+    const bool wasRunning = hal::timerActive(timer_);
     if (wasRunning) disableMotion();
     pwmMin_ = m;
     sr::out << "new min PWM value: " << pwmMin_ << sr::endl;
@@ -258,7 +472,7 @@ void ServoController::setAngleStep(const int angleStep) {
         sr::out << "angle-step size cannot exceed the maximum range of servo." << sr::endl;
         return;
     }
-    const bool wasRunning = esp_timer_is_active(timer_);
+    const bool wasRunning = hal::timerActive(timer_);
     if (wasRunning) disableMotion();
     angleStep_ = angleStep;
     sr::out << "new angle-step: " << angleStep_ << sr::endl;
@@ -266,28 +480,60 @@ void ServoController::setAngleStep(const int angleStep) {
 }
 
 void ServoController::setPosition(const int pos) {
-    const bool running = esp_timer_is_active(timer_);
+    const bool running = hal::timerActive(timer_);
     if (running) disableMotion();
     if (pos > maxAngle_) {
-        sr::out << "New position '" << pos << "' exceeds maximum range '" << maxAngle_ << "'. Setting to max angle." << sr::endl;
+        sr::warn << "New position '" << pos << "' exceeds maximum range '" << maxAngle_ << "'. Setting to max angle." << sr::endl;
         pos_ = maxAngle_;
     } else if (pos < 0) {
-        sr::out << F("New position cannot be < 0. Setting to 0.") << sr::endl;
+        sr::warn << F("New position cannot be < 0. Setting to 0.") << sr::endl;
         pos_ = 0;
     } else {
         sr::debug << "New position: " << pos << sr::endl;
         pos_ = pos;
     }
+    setpoint_ = pos_ * MILLI;
+    updateDuty();
+    if (running) enableMotion();
+    if (angleNotify_) angleNotify_(pos_);
+}
+void ServoController::setSetpoint(const MilliDegrees setpoint) {
+    const bool running = hal::timerActive(timer_);
+    if (running) disableMotion();
+    if (setpoint > maxAngle_ * MILLI) {
+        sr::warn << "New setpoint '" << setpoint << "' exceeds maximum range. Setting to max angle." << sr::endl;
+        setpoint_ = maxAngle_ * MILLI;
+    } else if (setpoint < 0) {
+        sr::warn << F("New setpoint cannot be < 0. Setting to 0.") << sr::endl;
+        setpoint_ = 0;
+    } else {
+        setpoint_ = setpoint;
+    }
+    pos_ = static_cast<int>((setpoint_ + MILLI / 2) / MILLI);
     updateDuty();
     if (running) enableMotion();
     if (angleNotify_) angleNotify_(pos_);
 }
+/* ------ Setpoint from a controller running at the sampling rate ------
+ * Called once per flex frame, so unlike setSetpoint() it neither logs a clamp nor restarts the motion it stops (the
+ * controller owns the servo from then on), and only notifies when the whole-degree position changes.
+ */
+void ServoController::track(const MilliDegrees setpoint) {
+    if (hal::timerActive(timer_)) disableMotion();
+    if (hal::timerActive(fallbackTimer_)) hal::timerStop(fallbackTimer_); // a LOOP's restart mustn't take it back
+    setpoint_ = setpoint < 0 ? 0 : setpoint > maxAngle_ * MILLI ? maxAngle_ * MILLI : setpoint;
+    updateDuty();
+    if (const int pos = static_cast<int>((setpoint_ + MILLI / 2) / MILLI); pos != pos_) {
+        pos_ = pos;
+        if (angleNotify_) angleNotify_(pos_);
+    }
+}
 void ServoController::setMotion(const Motion motion) {
     if (motion == INVALID) {
-        sr::out << "Disabling servo..." << sr::endl;
+        sr::warn << "Disabling servo..." << sr::endl;
         disableMotion();
     } else {
-        const bool wasRunning = esp_timer_is_active(timer_);
+        const bool wasRunning = hal::timerActive(timer_);
         if (wasRunning) disableMotion();
         motion_ = motion;
         sr::out << "New motion: " << motion_ << sr::endl;
@@ -296,10 +542,10 @@ void ServoController::setMotion(const Motion motion) {
 }
 void ServoController::setTimeDelay(const unsigned long delayUs) {
     if (delayUs < pwmMin_) {
-        sr::out << "new time delay (" << delayUs << "cannot be < minimum PWM value." << sr::endl;
+        sr::warn << "new time delay (" << delayUs << "cannot be < minimum PWM value." << sr::endl;
         return;
     }
-    const bool wasRunning = esp_timer_is_active(timer_);
+    const bool wasRunning = hal::timerActive(timer_);
     if (wasRunning) disableMotion();
     delayUs_ = delayUs;
     sr::out << "new time delay: " << delayUs_ << sr::endl;
@@ -307,14 +553,14 @@ void ServoController::setTimeDelay(const unsigned long delayUs) {
 }
 void ServoController::setStartAngle(const int startAngle) {
     if (startAngle < 0) {
-        sr::out << "new start angle cannot be < 0." << sr::endl;
+        sr::warn << "new start angle cannot be < 0." << sr::endl;
         return;
     }
     if (startAngle > maxAngle_) {
-        sr::out << "new start angle cannot be > maximum range." << sr::endl;
+        sr::warn << "new start angle cannot be > maximum range." << sr::endl;
         return;
     }
-    const bool wasRunning = esp_timer_is_active(timer_);
+    const bool wasRunning = hal::timerActive(timer_);
     if (wasRunning) disableMotion();
     startAngle_ = startAngle;
     sr::out << "new start angle: " << startAngle_ << sr::endl;
@@ -322,55 +568,63 @@ void ServoController::setStartAngle(const int startAngle) {
 }
 void ServoController::setStopAngle(const int stopAngle) {
     if (stopAngle < 0) {
-        sr::out << "new stop angle cannot be < 0." << sr::endl;
+        sr::warn << "new stop angle cannot be < 0." << sr::endl;
         return;
     }
     if (stopAngle > maxAngle_) {
-        sr::out << "new stop angle cannot be > maximum range." << sr::endl;
+        sr::warn << "new stop angle cannot be > maximum range." << sr::endl;
         return;
     }
-    const bool wasRunning = esp_timer_is_active(timer_);
+    const bool wasRunning = hal::timerActive(timer_);
     if (wasRunning) disableMotion();
     stopAngle_ = stopAngle;
     sr::out << "new stop angle: " << stopAngle_ << sr::endl;
     if (wasRunning) enableMotion();
 }
-void ServoController::updateDuty() const {
-    const auto pulse = map(static_cast<long>(pos_), 0,
-        static_cast<long>(maxAngle_),
-        static_cast<long>(pwmMin_),
-        static_cast<long>(pwmMax_));
-    constexpr uint32_t PERIOD_US = 20000;
-    constexpr uint32_t MAX_TICKS = (1u << 10) - 1;
-    const uint32_t duty = (pulse * MAX_TICKS) / PERIOD_US;
-    analogWrite(pin_, duty);
+/* ------ Setpoint -> duty, in integer math ------
+ * The pulse width is interpolated in ns between MIN_PWM and MAX_PWM, then scaled to LEDC counts over the 20 ms frame;
+ * both steps round to nearest. 64-bit, since a pulse in ns shifted up by PWM_BITS doesn't fit in 32.
+ */
+uint32_t ServoController::dutyFor(const MilliDegrees setpoint) const {
+    constexpr uint64_t PERIOD_NS = 1000000000ull / PWM_FREQUENCY;
+    const int64_t span = static_cast<int64_t>(maxAngle_) * MILLI;
+    const int64_t clamped = setpoint < 0 ? 0 : setpoint > span ? span : setpoint;
+    uint64_t pulseNs = static_cast<uint64_t>(pwmMin_) * 1000;
+    if (span > 0) pulseNs += (static_cast<uint64_t>(clamped) * (pwmMax_ - pwmMin_) * 1000 + span / 2) / span;
+    return static_cast<uint32_t>(((pulseNs << PWM_BITS) + PERIOD_NS / 2) / PERIOD_NS);
+}
+void ServoController::updateDuty() {
+    duty_ = dutyFor(setpoint_);
+    hal::pwmWrite(channel_, duty_);
 }
 void ServoController::setPin(uint8_t pin) {
-    bool wasRunning = esp_timer_is_active(timer_);
+    bool wasRunning = hal::timerActive(timer_);
     if (wasRunning) disableMotion();
+    hal::pwmDetach(pin_);
     pin_ = pin;
-    ledcAttachPin(pin_, channelCount);
+    hal::pwmAttach(pin_, channel_);
     sr::out << "new pin: " << pin_ << sr::endl;
     if (wasRunning) enableMotion();
 }
 void ServoController::enableMotion() {
-    if (esp_timer_is_active(timer_)) return;
-    const auto error = esp_timer_start_periodic(timer_, delayUs_);
-    if (error != ESP_OK) {
-        sr::out << "Failed to start servo timer." << sr::endl;
+    if (hal::timerActive(timer_)) return;
+    if (motion_ == INVALID) motion_ = LOOP;
+    playing_.store(playback_ && profile_ != STEP && compileTrajectory(), std::memory_order_release);
+    const auto error = hal::timerStartPeriodic(timer_, delayUs_);
+    if (error != hal::OK) {
+        playing_.store(false, std::memory_order_release);
+        sr::error << "Failed to start servo timer." << sr::endl;
         return;
     }
-    if (motion_ == INVALID) motion_ = LOOP;
     sr::out << "Servo enabled." << sr::endl;
 }
 
 /**
  * Method setting the maximum angle for servo—used in PWM signal calculation.
  * @param a is the maximum angle to set
- * @link esp_timer_create_args_t
  */
 void ServoController::setMaxAngle(unsigned int a) {
-    bool wasRunning = esp_timer_is_active(timer_);
+    bool wasRunning = hal::timerActive(timer_);
     if (wasRunning) disableMotion();
     maxAngle_ = a;
     sr::out << "new max angle: " << maxAngle_ << sr::endl;
@@ -379,12 +633,25 @@ void ServoController::setMaxAngle(unsigned int a) {
 
 
 void ServoController::disableMotion() {
-    if (!esp_timer_is_active(timer_)) return;
-    const auto error = esp_timer_stop(timer_);
-    if (error != ESP_OK) {
-        sr::out << "Failed to stop servo timer." << sr::endl;
+    planned_ = false;                                           // a restart plans from wherever the servo stopped
+    legTicks_ = 0;
+    if (!hal::timerActive(timer_)) {
+        playing_.store(false, std::memory_order_release);
+        return;
+    }
+    const auto error = hal::timerStop(timer_);
+    if (error != hal::OK) {
+        sr::error << "Failed to stop servo timer." << sr::endl;
         return;
     }
+    if (playing_.exchange(false, std::memory_order_seq_cst)) {
+        while (writing_.load(std::memory_order_acquire)) {}     // a playNext() already past its check finishes first
+        if (const size_t played = cursor_.load(std::memory_order_acquire); played != 0) {
+            setpoint_ = waypoints_[played - 1].setpoint;        // where the timer left the servo
+            duty_ = waypoints_[played - 1].duty;
+            pos_ = static_cast<int>((setpoint_ + MILLI / 2) / MILLI);
+        }
+    }
     sr::out << "Servo disabled." << sr::endl;
 }
 
@@ -7,14 +7,37 @@
  *
  *  This header file outlines the ServoController class, providing flexibility to accommodate various servo motors.
  *
+ *  Two ways of moving between the start and stop angles (setProfile()):
+ *      >> STEP (default): the original behaviour. Every TIME_DELAY the position moves by ANGLE_STEP whole degrees.
+ *      >> TRAPEZOID / S_CURVE: each leg of the motion is planned once (see 'MotionProfile.h') within MAX_VELOCITY,
+ *         MAX_ACCEL and MAX_JERK, and every TIME_DELAY the servo is sent the profile's setpoint for that instant, in
+ *         thousandths of a degree. TIME_DELAY is then only the update rate; ANGLE_STEP's sign still picks the
+ *         direction a SWEEP starts in. The motions keep their meaning: LOOP returns to the start angle at full speed
+ *         and restarts after the fallback delay, SWEEP reverses at each end (at rest), ONE_SHOT stops at the stop
+ *         angle.
+ *
+ *  Output: the servo pin is driven straight from an LEDC channel at PWM_FREQUENCY with PWM_BITS of duty resolution, the
+ *  most the S3's LEDC timers have. The setpoint (MilliDegrees, a fixed-point angle in thousandths of a degree) becomes a
+ *  pulse width in ns and then a duty in integer math, rounded to the nearest count: one count is 20 ms / 2^14 ≈ 1.2 µs,
+ *  about 0.17º on a 270º servo at 500 – 2500 µs (the old 10-bit duty was ≈ 2.6º), so every whole-degree step and most
+ *  profile updates move the horn.
+ *
+ *  Playback (setPlayback(), TRAPEZOID/S_CURVE only): instead of loop() working out each update when it next runs,
+ *  enableMotion() compiles the whole trajectory into a buffer of waypoints (duty + setpoint, one per TIME_DELAY) and the
+ *  timer callback writes the next duty straight to LEDC. The callback runs in the esp_timer task, above everything
+ *  the bridge does, so update timing no longer depends on how busy loop() is. loop() only follows along: it reports
+ *  the latest position once per call, however many waypoints played since, and handles the end of the trajectory.
+ *      >> A SWEEP compiles the leg to the first end plus one round trip, which the callback repeats until stopped.
+ *      >> A trajectory longer than MAX_WAYPOINTS updates falls back to updates from loop().
  *----------------------------------------------------------------------------------------------------------------------*/
 
 #pragma once
 #include <Arduino.h>
+#include <atomic>
 #include <functional>
-#include <esp_timer.h>
-#include <esp_event.h>
 #include "SerialStream.h"
+#include "Hal.h"
+#include "MotionProfile.h"
 /*
  * Class for controlling a servo motor with a PWM signal. This class provides flexibility, allowing the user to
  * change the PWM signal as it may differ among various servo motors. Standard servos typically provide a 180º range.
@@ -52,6 +75,34 @@ public:
         if (strcmp(motion, "ONE_SHOT") == 0) return ONE_SHOT;
         return INVALID;
     }
+    /* ------ How a leg between the start and stop angles is traversed ------ */
+    enum Profile {
+        STEP,                                                   // ANGLE_STEP whole degrees every TIME_DELAY
+        TRAPEZOID,                                              // velocity/acceleration-limited, sub-degree setpoints
+        S_CURVE,                                                // velocity/acceleration/jerk-limited, sub-degree setpoints
+        INVALID_PROFILE                                         // invalid profile specifier
+    };
+    static const char *profileString(const Profile profile) {
+        switch (profile) {
+            case STEP: return "STEP";
+            case TRAPEZOID: return "TRAPEZOID";
+            case S_CURVE: return "S_CURVE";
+            default: return "INVALID";
+        }
+    }
+    static Profile profileFromString(const char *profile) {
+        if (strcmp(profile, "STEP") == 0) return STEP;
+        if (strcmp(profile, "TRAPEZOID") == 0) return TRAPEZOID;
+        if (strcmp(profile, "S_CURVE") == 0) return S_CURVE;
+        return INVALID_PROFILE;
+    }
+    /* ------ Fixed-point angle: thousandths of a degree ------ */
+    using MilliDegrees = int32_t;
+    static constexpr MilliDegrees MILLI = 1000;                 // MilliDegrees per degree
+    // ------ PWM output ------
+    static constexpr uint32_t PWM_FREQUENCY = 50;               // Hz (a 20 ms servo frame)
+    static constexpr uint8_t PWM_BITS = 14;                     // LEDC duty resolution (the S3's maximum)
+    static constexpr size_t MAX_WAYPOINTS = 1024;               // Longest compiled trajectory (updates)
     // ------ Explicit constructor ------
     explicit ServoController(
         uint8_t pin = D4,                                       // Default pin @ D4
@@ -63,11 +114,11 @@ public:
      */
     void setup();
     /* ------ Loop method ------
-     * This method checks the volatile flag set by the actuation callback, determines whether
+     * This method takes the ticks counted by the actuation callback, determines whether
      * to run, and how to increment/decrement the position.
      *
-     * The portion checking the flag is guarded by a critical section macro,
-     * protecting the flag as the callback for the timer is an interruptible event.
+     * The count is an atomic the callback increments and loop() swaps for 0, so neither side
+     * locks; ticks beyond the first are the missed ones (getMissedTicks()).
      * Then, it checks the motion-mode, and continues actuating depending on the motion mode.
      * >> Loop: the intended direction is determined from the angle-step.
      *      - If decrementing (CW), the sum of the current position and angle step is compared to the
@@ -109,8 +160,30 @@ public:
 
     void setPosition(int pos);
     int getPosition() const { return pos_; }
+    void setSetpoint(MilliDegrees setpoint);                    // Like setPosition(), to a fraction of a degree
+    MilliDegrees getSetpoint() const { return setpoint_; }      // Commanded angle
+    void track(MilliDegrees setpoint);                          // Follow an external controller: stops any motion, clamps quietly
+    uint32_t getDuty() const { return duty_; }                  // Last duty written (0 – 2^PWM_BITS - 1)
 
-    bool isActive() const { return esp_timer_is_active(timer_); }
+    void setProfile(Profile profile);
+    Profile getProfile() const { return profile_; }
+
+    void setMaxVelocity(unsigned int velocity);                 // º/s
+    unsigned int getMaxVelocity() const { return maxVelocity_; }
+
+    void setMaxAccel(unsigned int accel);                       // º/s²
+    unsigned int getMaxAccel() const { return maxAccel_; }
+
+    void setMaxJerk(unsigned int jerk);                         // º/s³
+    unsigned int getMaxJerk() const { return maxJerk_; }
+
+    void setPlayback(bool playback);                            // Play compiled trajectories from the timer
+    bool getPlayback() const { return playback_; }
+    bool isPlaying() const { return playing_; }                 // Whether the current motion is being played back
+
+    bool isActive() const { return hal::timerActive(timer_); }
+    uint32_t getMissedTicks() const                             // Timer ticks that came before loop() took the last one
+        { return missedTicks_.load(std::memory_order_relaxed); }
 
 
     void enableMotion();
@@ -118,11 +191,28 @@ public:
     using callback = std::function<void(int angle)>;
 
     void addAngleNotify(std::function<void(int)> cb) { angleNotify_ = std::move(cb); }
+    void setWake(hal::Event *wake) { wake_ = wake; }            // Signalled whenever the timer leaves loop() work
 private:
     std::function<void(int angle)> angleNotify_;
-    void updateDuty() const;
-    volatile bool tick_;
+    //------------- Private types
+    struct Waypoint {                                           // One update of a compiled trajectory
+        MilliDegrees setpoint;
+        uint16_t duty;
+    };
+    uint32_t dutyFor(MilliDegrees setpoint) const;              // LEDC duty for a setpoint
+    void updateDuty();                                          // Write the duty for setpoint_
+    bool compileTrajectory();                                   // Fill waypoints_ for the current motion
+    bool compileLeg(MilliDegrees from, MilliDegrees to, size_t &count); // Append one leg to waypoints_
+    void followPlayback();                                      // loop()'s part while playing_
+    void playNext();                                            // Timer's part while playing_
+    void followProfile();                                       // One update of a TRAPEZOID/S_CURVE leg
+    bool planLeg();                                             // Plan the next leg from the current setpoint
+    std::atomic<uint32_t> ticks_;                               // Timer ticks loop() hasn't taken yet (timer -> loop())
+    std::atomic<uint32_t> missedTicks_{0};
+    hal::Event *wake_;                                          // Task running loop() (may be nullptr)
     uint8_t pin_;
+    uint8_t channel_;                                           // LEDC channel the pin is attached to
+    uint32_t duty_;
     int maxAngle_;
     Motion motion_;
     int pos_;
@@ -132,14 +222,26 @@ private:
     int startAngle_;
     int stopAngle_;
     int angleStep_;
-    esp_timer_handle_t timer_;
-    esp_timer_create_args_t timerArgs_;
-    esp_timer_handle_t fallbackTimer_;
-    esp_timer_create_args_t fallbackTimerArgs_;
+    MilliDegrees setpoint_;                                     // Commanded angle; pos_ is it rounded
+    Profile profile_;
+    unsigned int maxVelocity_;
+    unsigned int maxAccel_;
+    unsigned int maxJerk_;
+    MotionProfile leg_;                                         // Leg being followed
+    bool planned_;                                              // Whether leg_ is in progress
+    uint32_t legTicks_;                                         // Updates since leg_ started
+    bool playback_;                                             // Whether to compile trajectories when enabled
+    std::atomic<bool> playing_;                                 // Whether the timer is playing waypoints_
+    Waypoint waypoints_[MAX_WAYPOINTS];                         // Only written once disableMotion() has stopped the timer
+    size_t waypointCount_;
+    size_t cycleStart_;                                         // SWEEP repeats waypoints_[cycleStart_, count); else count
+    std::atomic<size_t> cursor_;                                // Waypoints played (the timer's next one)
+    std::atomic<bool> writing_;                                 // playNext() is between its playing_ check and its last store
+    hal::Timer timer_;
+    hal::Timer fallbackTimer_;
     static void timerCB(void *arg);
     static void fallbackTimerCB(void *arg);
     static uint8_t channelCount;
-    static portMUX_TYPE mux;
     uint64_t fallbackDelay;
 };
 
@@ -0,0 +1,66 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Per-task CPU load, stack headroom and per-core idle time, so sampling and servo rates can be sized against what
+ *  the cores actually have left (AsyncTCP, esp_timer, Wi-Fi and the bridge's own tasks all share them).
+ *      >> loop() takes a sample every period (see 'Hal.h', tasks()) and compares each task's run time with the previous
+ *         sample's: load is the share of one core the task used in between, in hundredths of a percent. A task free
+ *         to run on either core can exceed 100 %. A core's idle load is its headroom.
+ *      >> The first sample covers everything since boot; a task created in between counts from its creation.
+ *      >> Loads need the core's run-time stats; without them (window of 0) only names, priorities and stack marks are
+ *         meaningful.
+ *      >> The sample is published as a whole under a mutex, so snapshot() can be read from any task while loop() runs
+ *         in another.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <Arduino.h>
+#include <mutex>
+#include "Hal.h"
+
+class TaskMonitor {                         //  Samples the FreeRTOS task list
+public:
+    //------------- Constants
+    static constexpr uint32_t DEFAULT_PERIOD = 1000;                //  Between samples (ms)
+    static constexpr uint32_t MIN_PERIOD = 100;
+    static constexpr uint32_t MAX_PERIOD = 60000;
+    static constexpr uint16_t FULL_LOAD = 10000;                    //  Load of a task that ran the whole window on one core
+    //------------- Custom types
+    struct Task {
+        char name[hal::TASK_NAME_SIZE];                             //  Quotes, backslashes and control characters replaced by '_'
+        uint16_t load;                                              //  Share of one core over the window (0.01 %)
+        uint32_t stackFree;                                         //  Least free stack since the task started (bytes)
+        int8_t core;                                                //  Core it's pinned to, or hal::NO_CORE
+        uint8_t priority;
+    };
+    struct Snapshot {                                               //  One sample, busiest task first
+        Task tasks[hal::MAX_TASKS];
+        size_t count;                                               //  Tasks in tasks (0 before the first sample)
+        uint16_t idle[hal::CORES];                                  //  Each core's idle load (0.01 %)
+        uint32_t window;                                            //  Run-time clock the loads cover (µs, 0 if no run-time stats)
+    };
+    //------------- Arduino methods
+    void loop();                                                    //  Samples if a period has passed since the last sample
+    //------------- Sampling
+    void sample();                                                  //  Sample now
+    [[nodiscard]] Snapshot snapshot() const;                        //  Copy of the latest sample
+    void setPeriod(                                                 //  Set the time between samples
+        uint32_t ms)                                                    //  MIN_PERIOD – MAX_PERIOD
+        { period_ = ms; }
+    [[nodiscard]] uint32_t getPeriod() const                        //  Time between samples (ms)
+        { return period_; }
+private:
+    //------------- Private instance fields
+    Snapshot latest_{};                                             //  Published sample (guarded by lock_)
+    mutable std::mutex lock_;
+    uint32_t ids_[hal::MAX_TASKS] = {};                             //  Task numbers seen by the last sample
+    uint32_t runtimes_[hal::MAX_TASKS] = {};                        //  ... and their run times
+    size_t known_ = 0;                                              //  Entries in ids_/runtimes_
+    uint32_t clock_ = 0;                                            //  Run-time clock at the last sample
+    uint64_t lastSample_ = 0;                                       //  hal::micros() of the last sample
+    bool sampled_ = false;
+    uint32_t period_ = DEFAULT_PERIOD;                              //  ms
+};
@@ -39,6 +39,8 @@ document.addEventListener("DOMContentLoaded", () => {
     new ServoUI(ws);
     /* Instantiate a FlexUI object. */
     new FlexUI(ws, chart);
+    /* Instantiate a ControlUI object. */
+    new ControlUI(ws);
 });
 
 /**
@@ -51,6 +53,10 @@ class WSClient {
     constructor(url) {
         /* Instantiate a WebSocket object.*/
         this.ws = new WebSocket(url);
+        /* Deliver binary messages as ArrayBuffers so they can be read with a DataView. */
+        this.ws.binaryType = 'arraybuffer';
+        /* Ask for packed binary frames instead of one JSON message per reading (see StreamProtocol.h). */
+        this.ws.onopen = () => this.sendCommand('STREAM', 'SET', 'FORMAT', 'BINARY');
         /* Bind the _onMessage event handler to the onmessage event. */
         this.ws.onmessage = evt => this._onMessage(evt);
     }
@@ -63,7 +69,10 @@ class WSClient {
             eventName: UPDATE_FLEX,
             detail: {
                 sensor: 2,
-                reading: 1000
+                reading: 1000,
+                angle: 42.5,        // calibrated flex angle (º), null if the sensor isn't calibrated
+                sequence: 12,       // sampling tick (gaps mean dropped samples)
+                timestamp: 1200000  // device clock at acquisition (µs)
             };
 
             eventName: SERVO:ANGLE_STEP
@@ -83,6 +92,11 @@ class WSClient {
      * @private
      */
     _onMessage(evt) {
+        // Binary messages are streamed sensor frames, not JSON.
+        if (evt.data instanceof ArrayBuffer) {
+            this._onBinary(evt.data);
+            return;
+        }
         // Log event data
         console.log(evt.data);
         // Attempt to parse data as JSON.
@@ -146,6 +160,11 @@ class WSClient {
                                     case 'STOP_ANGLE':
                                     case 'MOTION':
                                     case 'MAX_ANGLE':
+                                    case 'PROFILE':
+                                    case 'PLAYBACK':
+                                    case 'MAX_VELOCITY':
+                                    case 'MAX_ACCEL':
+                                    case 'MAX_JERK':
                                     {
                                         // dispatch event with device and attribute, i.e., 'SERVO:ANGLE_STEP'
                                         document.dispatchEvent(new CustomEvent(`${dev}:${attr}`, {
@@ -191,7 +210,7 @@ class WSClient {
                         // if not set, check if get, assuming undefined is just a get response.
                         } else if (req === 'GET' || req === undefined) {
                             // check static attributes for flex sensor: sampling interval, start sampling, stop sampling.
-                            if (attr === 'SAMPLE_RATE') {
+                            if (attr === 'SAMPLE_RATE' || attr === 'OVERSAMPLE' || attr === 'CUTOFF' || attr === 'DECIMATE') {
                                 // dispatch sampling rate get response to update dom
                                 document.dispatchEvent(new CustomEvent("FLEX",
                                     {
@@ -240,8 +259,12 @@ class WSClient {
                     if (val === undefined) {
                         console.warn(`Missing val field for flex sensor. Message: ${msg}`);
                     } else {
+                        // a refused set (e.g. CAL_SAVE with too few points): re-request the value in effect
+                        if (req === 'SET' && stat !== 'OK') {
+                            console.warn(`Server responded with ${stat} to set ${dev} ${attr}.`);
+                            this.sendCommand(dev, 'GET', attr);
                         // check if a reading response, dispatching the value
-                        if (attr === 'READ') {
+                        } else if (attr === 'READ') {
                             document.dispatchEvent(new CustomEvent("UPDATE_FLEX", {
 
                                 detail: {
@@ -253,7 +276,7 @@ class WSClient {
                                 bubbles: true
                             }));
                             // check if pin attribute, dispatching sensor-specific custom event
-                        } else if (attr === 'PIN') {
+                        } else if (attr === 'PIN' || attr === 'CAL_POINT' || attr === 'CAL_SAVE' || attr === 'CAL_CLEAR') {
                             document.dispatchEvent(new CustomEvent(`${dev}`, {
                                 detail: {
                                     item: attr,
@@ -266,6 +289,61 @@ class WSClient {
                         }
                     }
                 } break;
+                // everything streamed since the last message (JSON clients only; binary clients get _onBinary)
+                case 'BATCH':
+                {
+                    for (const frame of msg.flex ?? []) {
+                        this._dispatchFrame({
+                            mask: frame.mask,
+                            sequence: frame.seq,
+                            timestamp: frame.ts,
+                            readings: frame.val,
+                            angles: frame.ang
+                        });
+                    }
+                    if (msg.servo !== undefined) this._dispatchServo(msg.servo);
+                } break;
+                // every attribute at once, sent when this client connects (layout in commands.txt)
+                case 'CONFIG':
+                {
+                    // only apply layouts this page knows; 'ver' is bumped whenever the layout changes
+                    if (msg.ver !== 1) {
+                        console.warn(`Unsupported CONFIG version ${msg.ver}. Received: ${msg}`);
+                    } else {
+                        document.dispatchEvent(new CustomEvent("CONFIG", {
+                            detail: val, // {SERVO: {...}, FLEX: {...}, FLEX_2: {PIN}, ...}
+                            bubbles: true
+                        }));
+                    }
+                } break;
+                // on-device flex -> servo control
+                case 'CONTROL':
+                {
+                    if (req === 'SET') {
+                        if (stat !== 'OK') {
+                            console.warn(`Server responded with ${stat} to set control ${attr} to ${val}. `
+                                + `Sending GET request to retrieve last successful value.`);
+                            this.sendCommand(dev, 'GET', attr);
+                        }
+                    } else if (val === undefined) {
+                        console.warn(`Missing val field for control. Message: ${msg}`);
+                    } else {
+                        // dispatch event with device and attribute, i.e., 'CONTROL:KP'
+                        document.dispatchEvent(new CustomEvent(`${dev}:${attr}`, {
+                            detail: val,
+                            bubbles: true
+                        }));
+                    }
+                } break;
+                // stream options of this client
+                case 'STREAM':
+                {
+                    if (req === 'SET' && stat !== 'OK') {
+                        console.warn(`Server responded with ${stat} to set stream ${attr} to ${val}.`);
+                    } else {
+                        console.log(`Stream ${attr}: ${val}`);
+                    }
+                } break;
                 // unknown device case, warn
                 default: console.warn(`Unknown dev: ${dev}`); break;
             }
@@ -275,6 +353,87 @@ class WSClient {
         }
     }
 
+    /**
+     * Decodes a binary BATCH message (layout documented in StreamProtocol.h), dispatching
+     *  the servo angle (if present) and every flex record, same as a JSON BATCH message.
+     *
+     * @param buf is the ArrayBuffer received.
+     * @private
+     */
+    _onBinary(buf) {
+        const view = new DataView(buf);
+        // first byte is the message type; 0xF2 is a batch
+        if (view.byteLength < 5 || view.getUint8(0) !== 0xF2) {
+            console.warn(`Unknown binary message (${view.byteLength} bytes)`);
+            return;
+        }
+        const count = view.getUint8(1);
+        // bit 0 of the flags means the servo angle is new
+        if (view.getUint8(2) & 0x01) {
+            this._dispatchServo(view.getInt16(3, true));
+        }
+        for (let n = 0; n < count; n++) {
+            // 29-byte records start after the 5-byte header
+            const base = 5 + 29 * n;
+            if (base + 29 > view.byteLength) {
+                console.warn(`Truncated batch: ${count} records in ${view.byteLength} bytes`);
+                break;
+            }
+            const readings = [];
+            const angles = [];
+            for (let i = 0; i < 4; i++) readings.push(view.getUint16(base + 13 + 2 * i, true));
+            for (let i = 0; i < 4; i++) {
+                // -32768 marks a channel without a calibration
+                const angle = view.getInt16(base + 21 + 2 * i, true);
+                angles.push(angle === -32768 ? null : angle);
+            }
+            this._dispatchFrame({
+                mask: view.getUint8(base),
+                sequence: view.getUint32(base + 1, true),
+                timestamp: Number(view.getBigUint64(base + 5, true)),
+                readings: readings,
+                angles: angles
+            });
+        }
+    }
+
+    /**
+     * Dispatches one UPDATE_FLEX event per sampled channel of a flex frame.
+     *
+     * @param frame is {mask, sequence, timestamp, readings[4], angles[4]}, channel 0 being FLEX_2. Angles are in
+     *  hundredths of a degree, null for uncalibrated channels.
+     * @private
+     */
+    _dispatchFrame(frame) {
+        for (let i = 0; i < 4; i++) {
+            // skip channels that weren't sampled
+            if ((frame.mask & (1 << i)) === 0) continue;
+            document.dispatchEvent(new CustomEvent("UPDATE_FLEX", {
+                detail: {
+                    sensor: i + 2,
+                    reading: frame.readings[i],
+                    angle: frame.angles?.[i] == null ? null : frame.angles[i] / 100,
+                    sequence: frame.sequence,
+                    timestamp: frame.timestamp
+                },
+                bubbles: true
+            }));
+        }
+    }
+
+    /**
+     * Dispatches a streamed servo angle.
+     *
+     * @param angle is the servo's position (º).
+     * @private
+     */
+    _dispatchServo(angle) {
+        document.dispatchEvent(new CustomEvent("UPDATE_SERVO", {
+            detail: angle,
+            bubbles: true
+        }));
+    }
+
     /**
      * Send command to server.
      * @param dev is the device (String, SERVO/FLEX/FLEX_2/FLEX_3/FLEX_4/FLEX_5)
@@ -326,12 +485,30 @@ class ServoUI {
             pin: document.getElementById("SERVO PIN"),
             minPwm: document.getElementById("SERVO MIN_PWM"),
             maxPwm: document.getElementById("SERVO MAX_PWM"),
-            maxAngle: document.getElementById("SERVO MAX_ANGLE")
+            maxAngle: document.getElementById("SERVO MAX_ANGLE"),
+            profile: document.getElementById("SERVO PROFILE"),
+            playback: document.getElementById("SERVO PLAYBACK"),
+            maxVelocity: document.getElementById("SERVO MAX_VELOCITY"),
+            maxAccel: document.getElementById("SERVO MAX_ACCEL"),
+            maxJerk: document.getElementById("SERVO MAX_JERK")
         };
         // bind angle notifier to position input
         document.addEventListener("UPDATE_SERVO", evt => {
             this.el.position.valueAsNumber = evt.detail;
         });
+        // apply the connect snapshot to every servo element in one pass
+        document.addEventListener("CONFIG", evt => {
+            const servo = evt.detail.SERVO ?? {};
+            for (const element of Object.values(this.el)) {
+                const value = servo[element.id.split(' ')[1]];
+                if (value === undefined) continue; // not in the snapshot (e.g. the actuate buttons)
+                if (element.type === 'select-one') {
+                    element.value = value;
+                } else if (element.type === 'number') {
+                    element.valueAsNumber = value;
+                }
+            }
+        });
         // attribute is the second word in the id
         for (const element of Object.values(this.el)) {
             const attr = element.id.split(' ')[1];
@@ -378,11 +555,58 @@ class ServoUI {
         }
     }
 }
+/**
+ * Class for managing the closed-loop control panel. Elements are bound by id ("CONTROL <attr>") the same
+ * way ServoUI binds its own.
+ *
+ * @param ws is the WebSocket object.
+ */
+class ControlUI {
+    constructor(ws) {
+        this.ws = ws;
+        this.el = {
+            mode: document.getElementById("CONTROL MODE"),
+            channels: document.getElementById("CONTROL CHANNELS"),
+            target: document.getElementById("CONTROL TARGET"),
+            deadband: document.getElementById("CONTROL DEADBAND"),
+            gain: document.getElementById("CONTROL GAIN"),
+            offset: document.getElementById("CONTROL OFFSET"),
+            kp: document.getElementById("CONTROL KP"),
+            ki: document.getElementById("CONTROL KI"),
+            kd: document.getElementById("CONTROL KD")
+        };
+        // apply the connect snapshot
+        document.addEventListener("CONFIG", evt => {
+            const control = evt.detail.CONTROL ?? {};
+            for (const element of Object.values(this.el)) {
+                const value = control[element.id.split(' ')[1]];
+                if (value !== undefined) this._show(element, value);
+            }
+        });
+        for (const element of Object.values(this.el)) {
+            const attr = element.id.split(' ')[1];
+            // responses and other dashboards' changes
+            document.addEventListener(`CONTROL:${attr}`, evt => this._show(element, evt.detail));
+            // changes made here
+            element.addEventListener('change', evt => {
+                const val = element.type === 'number' ? evt.target.valueAsNumber : evt.target.value;
+                this.ws.sendCommand("CONTROL", "SET", attr, val);
+            });
+        }
+    }
+
+    _show(element, value) {
+        if (element.type === 'select-one') {
+            element.value = value;
+        } else if (element.type === 'number') {
+            element.valueAsNumber = value;
+        }
+    }
+}
 class FlexUI {
     constructor(ws, graph) {
         this.ws = ws;
         this.graph = graph; // assign the smoothie chart
-        this.maxVoltage = 3.3;
         this.series2 = new TimeSeries(); // time series for each sensor
         this.series3 = new TimeSeries();
         this.series4 = new TimeSeries();
@@ -392,6 +616,15 @@ class FlexUI {
         this.graph.addTimeSeries(this.series3, {strokeStyle:'rgb(0,255,0)', lineWidth:2 }); // middle
         this.graph.addTimeSeries(this.series4, {strokeStyle:'rgb(0,196,255)', lineWidth:2 }); // ring
         this.graph.addTimeSeries(this.series5, {strokeStyle:'rgb(255,98,0)', lineWidth:2 }); // pinky
+        // samples are plotted on the device's clock (see plotTime)
+        this.clockOffset = null;    // page time - device time (ms), null until the first sample
+        this.lastTimestamp = 0;     // latest device timestamp seen (µs)
+        this.sampleInterval = null; // FLEX SAMPLE_RATE (µs), for jitter
+        this.decimation = 1;        // FLEX DECIMATE: frames are SAMPLE_RATE * DECIMATE apart
+        this.streams = {};          // per sensor: {sequence, timestamp, gaps, jitter}
+        this.calibration = {};      // per sensor: {points captured, saved (angles are being sent)}
+        for (const n of [2, 3, 4, 5]) this.calibration[n] = {points: 0, saved: false};
+        for (const n of [2, 3, 4, 5]) this.streams[n] = {sequence: null, timestamp: 0, gaps: 0, jitter: 0};
         this.el = {
             pin2: document.getElementById("FLEX_2 PIN"),    // store all DOM elements within this class
             pin3: document.getElementById("FLEX_3 PIN"),
@@ -401,18 +634,26 @@ class FlexUI {
             reading3: document.getElementById("FLEX_3 READ"),
             reading4: document.getElementById("FLEX_4 READ"),
             reading5: document.getElementById("FLEX_5 READ"),
-            fixed2: document.getElementById("FLEX_2 FIXED_RESIST"),
-            fixed3: document.getElementById("FLEX_3 FIXED_RESIST"),
-            fixed4: document.getElementById("FLEX_4 FIXED_RESIST"),
-            fixed5: document.getElementById("FLEX_5 FIXED_RESIST"),
-            volt2: document.getElementById("FLEX_2 VOLT"),
-            volt3: document.getElementById("FLEX_3 VOLT"),
-            volt4: document.getElementById("FLEX_4 VOLT"),
-            volt5: document.getElementById("FLEX_5 VOLT"),
-            resist2: document.getElementById("FLEX_2 RESIST"),
-            resist3: document.getElementById("FLEX_3 RESIST"),
-            resist4: document.getElementById("FLEX_4 RESIST"),
-            resist5: document.getElementById("FLEX_5 RESIST"),
+            calAngle2: document.getElementById("FLEX_2 CAL_POINT"),
+            calAngle3: document.getElementById("FLEX_3 CAL_POINT"),
+            calAngle4: document.getElementById("FLEX_4 CAL_POINT"),
+            calAngle5: document.getElementById("FLEX_5 CAL_POINT"),
+            angle2: document.getElementById("FLEX_2 ANGLE"),
+            angle3: document.getElementById("FLEX_3 ANGLE"),
+            angle4: document.getElementById("FLEX_4 ANGLE"),
+            angle5: document.getElementById("FLEX_5 ANGLE"),
+            cal2: document.getElementById("FLEX_2 CAL"),
+            calSave2: document.getElementById("FLEX_2 CAL_SAVE"),
+            calClear2: document.getElementById("FLEX_2 CAL_CLEAR"),
+            cal3: document.getElementById("FLEX_3 CAL"),
+            calSave3: document.getElementById("FLEX_3 CAL_SAVE"),
+            calClear3: document.getElementById("FLEX_3 CAL_CLEAR"),
+            cal4: document.getElementById("FLEX_4 CAL"),
+            calSave4: document.getElementById("FLEX_4 CAL_SAVE"),
+            calClear4: document.getElementById("FLEX_4 CAL_CLEAR"),
+            cal5: document.getElementById("FLEX_5 CAL"),
+            calSave5: document.getElementById("FLEX_5 CAL_SAVE"),
+            calClear5: document.getElementById("FLEX_5 CAL_CLEAR"),
             start: document.getElementById('FLEX START'),
             stop: document.getElementById('FLEX STOP')
         };
@@ -424,9 +665,13 @@ class FlexUI {
                     this.ws.sendCommand(`${element.id.split(' ')[0]}`, 'SET', 'PIN', evt.target.value === 'false' ? 'false' : parseInt(evt.target.value));
                 });
                 //
-            } else if (element.type === 'number') {
+            } else if (element.type === 'number') {            // must be a calibration angle: capture the current reading at it
                 element.addEventListener('change', evt => {
-                    this.ws.sendCommand(`${element.id.split(' ')[0]}`, 'SET', 'PIN', parseInt(evt.target.value));
+                    this.ws.sendCommand(`${element.id.split(' ')[0]}`, 'SET', 'CAL_POINT', parseInt(evt.target.value));
+                });
+            } else if (element.id.endsWith('CAL_SAVE') || element.id.endsWith('CAL_CLEAR')) {
+                element.addEventListener('click', () => {
+                    this.ws.sendCommand(`${element.id.split(' ')[0]}`, 'SET', element.id.split(' ')[1], "");
                 });
             } else if (element.id === 'FLEX START') {
                 element.addEventListener('click', () => {
@@ -442,39 +687,60 @@ class FlexUI {
             }
         }
         document.addEventListener("UPDATE_FLEX", evt => {
-            const voltage = this.getVoltage(evt.detail.reading).toFixed(4);
+            // angles are computed on the device from each sensor's calibration table
+            const angle = evt.detail.angle == null ? '--' : evt.detail.angle.toFixed(2);
+            this.track(evt.detail.sensor, evt.detail.sequence, evt.detail.timestamp);
+            const time = this.plotTime(evt.detail.timestamp);
             switch (evt.detail.sensor) {
                 case 2: {
                     this.el.reading2.textContent = evt.detail.reading;
-                    this.el.volt2.textContent = voltage;
-                    this.el.resist2.textContent = this.getResistance(this.el.fixed2, voltage);
-                    this.series2.append(Date.now(), evt.detail.reading);
+                    this.el.angle2.textContent = angle;
+                    this.series2.append(time, evt.detail.reading);
                 } break;
                 case 3: {
                     this.el.reading3.textContent = evt.detail.reading;
-                    this.el.volt3.textContent = voltage;
-                    this.el.resist3.textContent = this.getResistance(this.el.fixed3, voltage);
-                    this.series3.append(Date.now(), evt.detail.reading);
+                    this.el.angle3.textContent = angle;
+                    this.series3.append(time, evt.detail.reading);
                 } break;
                 case 4:
                     this.el.reading4.textContent = evt.detail.reading;
-                    this.el.volt4.textContent = voltage;
-                    this.el.resist4.textContent = this.getResistance(this.el.fixed4, voltage);
-                    this.series4.append(Date.now(), evt.detail.reading);
+                    this.el.angle4.textContent = angle;
+                    this.series4.append(time, evt.detail.reading);
                     break;
                 case 5:
                     this.el.reading5.textContent = evt.detail.reading;
-                    this.el.volt5.textContent = voltage;
-                    this.el.resist5.textContent = this.getResistance(this.el.fixed5, voltage);
-                    this.series5.append(Date.now(), evt.detail.reading);
+                    this.el.angle5.textContent = angle;
+                    this.series5.append(time, evt.detail.reading);
                     break;
                 default: console.warn(`Unknown sensor: ${evt.detail.sensor}`);
                     break;
             }
         });
+        // apply the connect snapshot's pins in one pass
+        document.addEventListener("CONFIG", evt => {
+            const pins = {2: this.el.pin2, 3: this.el.pin3, 4: this.el.pin4, 5: this.el.pin5};
+            for (const [n, element] of Object.entries(pins)) {
+                const pin = evt.detail[`FLEX_${n}`]?.PIN;
+                if (pin === undefined) continue;
+                element.value = pin === false ? 'false' : pin;
+            }
+            for (const n of [2, 3, 4, 5]) {
+                const flex = evt.detail[`FLEX_${n}`];
+                if (flex?.CAL_POINT !== undefined) this.calibration[n].points = flex.CAL_POINT;
+                if (flex?.CAL_SAVE !== undefined) this.calibration[n].saved = flex.CAL_SAVE;
+                this.showCalibration(n);
+            }
+            if (evt.detail.FLEX?.SAMPLE_RATE !== undefined) this.sampleInterval = evt.detail.FLEX.SAMPLE_RATE;
+            if (evt.detail.FLEX?.DECIMATE !== undefined) this.decimation = evt.detail.FLEX.DECIMATE;
+        });
         document.addEventListener("FLEX", evt => {
             if (evt.detail.item === 'SAMPLE_RATE') {
                 console.log(`Successfully received SAMPLE_RATE update request.`);
+                this.sampleInterval = evt.detail.value;
+            } else if (evt.detail.item === 'DECIMATE') {
+                this.decimation = evt.detail.value;
+            } else if (evt.detail.item === 'OVERSAMPLE' || evt.detail.item === 'CUTOFF') {
+                console.log(`FLEX ${evt.detail.item}: ${evt.detail.value}`);
             } else if (evt.detail.item === 'START') {
                 console.log(`Successfully received START update request.`);
             } else if (evt.detail.item === 'STOP') {
@@ -490,6 +756,8 @@ class FlexUI {
                 } else {
                     this.el.pin2.value = evt.detail.value;
                 }
+            } else if (evt.detail.item.startsWith('CAL_')) {
+                this.applyCalibration(2, evt.detail.item, evt.detail.value);
             } else {
                 console.warn(`Unknown FLEX_2 item: ${evt.detail}`);
             }
@@ -501,6 +769,8 @@ class FlexUI {
                 } else {
                     this.el.pin3.value = evt.detail.value;
                 }
+            } else if (evt.detail.item.startsWith('CAL_')) {
+                this.applyCalibration(3, evt.detail.item, evt.detail.value);
             } else {
                 console.warn(`Unknown FLEX_3 item: ${evt.detail}`);
             }
@@ -512,6 +782,8 @@ class FlexUI {
                 } else {
                     this.el.pin4.value = evt.detail.value;
                 }
+            } else if (evt.detail.item.startsWith('CAL_')) {
+                this.applyCalibration(4, evt.detail.item, evt.detail.value);
             } else {
                 console.warn(`Unknown FLEX_4 item: ${evt.detail}`);
             }
@@ -523,16 +795,77 @@ class FlexUI {
                 } else {
                     this.el.pin5.value = evt.detail.value;
                 }
+            } else if (evt.detail.item.startsWith('CAL_')) {
+                this.applyCalibration(5, evt.detail.item, evt.detail.value);
             } else {
                 console.warn(`Unknown FLEX_5 item: ${evt.detail}`);
             }
         });
     }
-    // [voltage, resistance]
-    getVoltage(adc) {
-        return adc / 4095.0 * this.maxVoltage;
+    /**
+     * Maps a sample's device timestamp (µs since boot) to the page time smoothie plots it at (ms).
+     *  The offset between the clocks is the smallest (arrival - device time) seen so far, i.e. from the sample that
+     *  crossed the network fastest, so Wi-Fi delay and jitter change when a sample shows up, not where it's drawn.
+     *  A timestamp going backwards means the device restarted, so the estimate starts over.
+     *
+     * @param timestamp is the device time the sample was taken at (µs).
+     * @returns {number} page time to plot the sample at (ms).
+     */
+    plotTime(timestamp) {
+        if (timestamp === undefined) return Date.now(); // legacy single readings carry no timestamp
+        if (timestamp < this.lastTimestamp) this.clockOffset = null;
+        this.lastTimestamp = timestamp;
+        const device = timestamp / 1000;
+        const offset = Date.now() - device;
+        if (this.clockOffset === null || offset < this.clockOffset) this.clockOffset = offset;
+        return device + this.clockOffset;
+    }
+    /**
+     * Gap and jitter detection for one sensor's stream. Sequence numbers count sampling ticks, so a jump of more
+     *  than one means samples were dropped on the device; jitter is the furthest the spacing of two samples has
+     *  strayed from what the sampling interval says it should be.
+     *
+     * @param sensor is the sensor number (2 – 5).
+     * @param sequence is the sample's sequence number.
+     * @param timestamp is the sample's device timestamp (µs).
+     */
+    track(sensor, sequence, timestamp) {
+        const stream = this.streams[sensor];
+        if (stream === undefined || sequence === undefined) return;
+        if (stream.sequence !== null && sequence > stream.sequence) {
+            const missed = sequence - stream.sequence - 1;
+            if (missed > 0) {
+                stream.gaps += missed;
+                console.warn(`FLEX_${sensor}: ${missed} sample(s) missing before #${sequence} (${stream.gaps} total).`);
+            }
+            if (this.sampleInterval) {
+                const expected = (sequence - stream.sequence) * this.sampleInterval * this.decimation;
+                const deviation = Math.abs(timestamp - stream.timestamp - expected);
+                // sampling stops and starts without skipping sequence numbers; a pause isn't jitter
+                if (deviation < expected) stream.jitter = Math.max(stream.jitter, deviation);
+            }
+        }
+        stream.sequence = sequence; // a lower number means the device restarted; start over from it
+        stream.timestamp = timestamp;
+    }
+    /**
+     * Records a calibration response for one sensor and refreshes its status cell.
+     *
+     * @param sensor is the sensor number (2 – 5).
+     * @param item is CAL_POINT (value: points captured), CAL_SAVE or CAL_CLEAR (value: whether a table is in use).
+     * @param value is the response's value.
+     */
+    applyCalibration(sensor, item, value) {
+        if (item === 'CAL_POINT') {
+            this.calibration[sensor].points = value;
+        } else {
+            this.calibration[sensor].saved = value;
+            if (item === 'CAL_CLEAR') this.calibration[sensor].points = 0;
+        }
+        this.showCalibration(sensor);
     }
-    getResistance(fixedResist, voltage) {
-        return fixedResist * voltage / (this.maxVoltage - voltage);
+    showCalibration(sensor) {
+        const {points, saved} = this.calibration[sensor];
+        this.el[`cal${sensor}`].textContent = `${saved ? 'Calibrated' : 'Not calibrated'} (${points} pts)`;
     }
 }
\ No newline at end of file
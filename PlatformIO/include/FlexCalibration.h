@@ -0,0 +1,73 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Count -> flex angle conversion for one sensor, built from a calibration sweep: the wearer holds the finger at a few
+ *  known angles and each one is captured (capture()) against the sensor's current reading. build() then precomputes a
+ *  table with one entry per ADC count, so converting a sample is a single lookup (angle()).
+ *      >> Captured readings are converted to millivolts with the eFuse ADC characteristics (hal::adcMilliVolts()) and
+ *         the sweep is kept in millivolts, so it describes the sensor and its divider rather than one chip's ADC.
+ *         The table folds the characteristics back in: entry n is the angle at hal::adcMilliVolts(n).
+ *      >> Between captured points the angle is interpolated linearly in millivolts; beyond the first and last point it
+ *         is held at their angles, so a noisy reading can't command a finger past the calibrated range.
+ *      >> save()/load() persist the sweep (not the table) under the sensor's name, and load() rebuilds the table.
+ *         The table is 8 KB per sensor, which is why it's computed at boot rather than stored.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "Hal.h"
+
+class FlexCalibration {                     //  Class holding one sensor's sweep and its lookup table
+public:
+    //------------- Constants
+    static constexpr size_t MAX_POINTS = 8;                         //  Most angles captured per sweep
+    static constexpr size_t TABLE_SIZE = 4096;                      //  One entry per 12-bit ADC count
+    static constexpr int16_t NO_ANGLE = INT16_MIN;                  //  angle() of an uncalibrated sensor
+    static constexpr int16_t MAX_ANGLE = 180 * 100;                 //  Largest angle a point may be captured at (0.01º)
+    //------------- Custom types
+    struct Point {                                                  //  One captured angle
+        uint16_t milliVolts;                                        //  Sensor voltage at the angle (mV, eFuse-corrected)
+        int16_t angle;                                              //  Angle the finger was held at (0.01º)
+    };
+    //------------- Constructor
+    FlexCalibration();
+    //------------- Instance methods
+    bool capture(                                                   //  Add a point to the sweep (replacing one at the same angle)
+        uint16_t reading,                                               //  Sensor's current 12-bit reading
+        int16_t angle);                                                 //  Angle it's held at (0.01º), 0 – MAX_ANGLE
+    bool build();                                                   //  Compute the table from the sweep. Needs 2+ points at distinct voltages.
+    void clear();                                                   //  Drop the sweep and the table
+    bool save(                                                      //  Persist the sweep
+        const char *key) const;                                         //  Settings key (the sensor's name)
+    bool load(                                                      //  Restore a saved sweep and build its table
+        const char *key);                                               //  Settings key (the sensor's name)
+    static bool erase(                                              //  Remove a saved sweep
+        const char *key);                                               //  Settings key (the sensor's name)
+    [[nodiscard]] int16_t angle(                                    //  Angle (0.01º) at a reading, NO_ANGLE if not calibrated
+        const uint16_t reading) const
+        { return built_ ? table_[reading < TABLE_SIZE ? reading : TABLE_SIZE - 1] : NO_ANGLE; }
+    [[nodiscard]] bool isBuilt() const                              //  Whether angle() has a table to look in
+        { return built_; }
+    [[nodiscard]] size_t getPointCount() const                      //  Points captured so far
+        { return count_; }
+    [[nodiscard]] const Point &getPoint(                            //  A captured point, in ascending voltage
+        const size_t i) const
+        { return points_[i]; }
+private:
+    //------------- Private types
+    struct Stored {                                                 //  Layout saved in settings; bump VERSION when it changes
+        uint8_t version;
+        uint8_t count;
+        Point points[MAX_POINTS];
+    };
+    static constexpr uint8_t VERSION = 1;
+    //------------- Private instance fields
+    Point points_[MAX_POINTS];                                      //  The sweep, sorted by voltage
+    size_t count_;                                                  //  Points in the sweep
+    int16_t table_[TABLE_SIZE];                                     //  Angle (0.01º) per ADC count
+    bool built_;                                                    //  Whether table_ matches the sweep
+};
@@ -0,0 +1,81 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Fixed pool of message slots handed from the AsyncTCP task (producer) to the loop (consumer) without copying or
+ *  allocating. The producer acquires a free slot, writes the message into it, and commits it; the consumer takes
+ *  committed slots in order, parses them in place, and releases them back. Both hand-offs go through SpscRing, so
+ *  neither side ever blocks.
+ *      >> Slot indices only travel producer -> consumer through ready_ and consumer -> producer through free_.
+ *         A slot the producer gives up on (oversized or interrupted message) is kept on a producer-only spare
+ *         stack instead of being pushed to free_, which would make free_ multi-producer.
+ *      >> If no slot is free the message is dropped and counted; commands never wait for memory.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "SpscRing.h"
+
+template <size_t SLOTS, size_t SLOT_SIZE>
+class MessagePool {
+    static_assert(SLOTS >= 2 && (SLOTS & (SLOTS - 1)) == 0, "MessagePool slot count must be a power of two");
+    static_assert(SLOTS <= UINT8_MAX, "MessagePool slot indices are stored as bytes");
+public:
+    static constexpr size_t CAPACITY = SLOT_SIZE;               // Longest message a slot holds (excl. terminator)
+    struct Slot {
+        uint32_t client;                                        // Id of the client that sent the message
+        size_t length;                                          // Bytes in data (excl. terminator)
+        char data[SLOT_SIZE + 1];                               // Message, null-terminated on commit
+    };
+    MessagePool() : spareCount_(0) {
+        for (size_t i = 0; i < SLOTS; i++) spare_[spareCount_++] = static_cast<uint8_t>(i);
+    }
+    // ------ Producer side ------
+    Slot *acquire() {                                           // nullptr (and a counted drop) if every slot is in use
+        uint8_t index;
+        if (spareCount_ > 0) {
+            index = spare_[--spareCount_];
+        } else if (!free_.pop(index)) {
+            drops_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        slots_[index].length = 0;
+        return &slots_[index];
+    }
+    void commit(Slot *slot) {                                   // Hand a filled slot to the consumer
+        slot->data[slot->length] = '\0';
+        ready_.push(indexOf(slot));                             // can't overflow: SLOTS indices exist in total
+    }
+    void abandon(Slot *slot) {                                  // Give a slot back without delivering it
+        spare_[spareCount_++] = indexOf(slot);
+    }
+    void countOversize() {                                      // Record a message that didn't fit in a slot
+        oversize_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // ------ Consumer side ------
+    Slot *next() {                                              // Oldest committed slot, nullptr if none
+        uint8_t index;
+        if (!ready_.pop(index)) return nullptr;
+        return &slots_[index];
+    }
+    void release(Slot *slot) {                                  // Return a slot taken with next()
+        free_.push(indexOf(slot));
+    }
+    // ------ Either side ------
+    [[nodiscard]] uint32_t drops() const { return drops_.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint32_t oversize() const { return oversize_.load(std::memory_order_relaxed); }
+    [[nodiscard]] size_t pending() const { return ready_.size(); }
+private:
+    uint8_t indexOf(const Slot *slot) const { return static_cast<uint8_t>(slot - slots_); }
+    Slot slots_[SLOTS];
+    SpscRing<uint8_t, SLOTS> ready_;                            // Producer -> consumer
+    SpscRing<uint8_t, SLOTS> free_;                             // Consumer -> producer
+    uint8_t spare_[SLOTS];                                      // Producer-only free slots
+    size_t spareCount_;
+    std::atomic<uint32_t> drops_{0};                            // Messages dropped because no slot was free
+    std::atomic<uint32_t> oversize_{0};                         // Messages dropped because they exceeded SLOT_SIZE
+};
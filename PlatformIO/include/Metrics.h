@@ -0,0 +1,91 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Latency probes for the bridge's hot paths. A metrics::Scope reads the core's cycle counter when it's created and
+ *  again when it goes out of scope, and adds the difference (in µs) to a fixed-bucket histogram: no allocation, no
+ *  lock, two counter reads and a handful of relaxed atomic adds per probe.
+ *      >> Each histogram has one writer (the task running the probed code); readers (the /metrics route, the STATS
+ *         device) may see a sample counted in a bucket a moment before it shows up in count(). reset() is likewise
+ *         only approximate while the writer is recording.
+ *      >> The cycle counter is per core, so a probe must start and end on the same core: the bridge only probes code
+ *         running in its core-pinned tasks. Durations of more than one counter wrap (~18 s at 240 MHz) aren't
+ *         measured correctly.
+ *      >> writePrometheus() formats one histogram in the Prometheus text format (cumulative buckets, _sum, _count).
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <Print.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "Hal.h"
+
+namespace metrics {
+    enum Probe : uint8_t {
+        SERVO_LOOP,                                             // servo_.loop() (control task)
+        FLEX_LOOP,                                              // sensors_.loop(), incl. the frame notifier (control task)
+        REQUEST,                                                // handleReceived(): parse, command, reply (network task)
+        ENCODE,                                                 // encoding one telemetry batch (network task)
+        SEND,                                                   // handing one batch to AsyncWebSocket (network task)
+        PROBES
+    };
+    constexpr const char *PROBE_NAMES[PROBES] = {"servo_loop", "flex_loop", "request", "encode", "send"};
+    constexpr uint32_t BOUNDS[] = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000}; // Bucket upper bounds (µs)
+    constexpr size_t BUCKETS = sizeof(BOUNDS) / sizeof(BOUNDS[0]) + 1; // The last bucket is everything longer
+
+    class Histogram {
+    public:
+        void record(const uint32_t us) {
+            size_t bucket = 0;
+            while (bucket < BUCKETS - 1 && us > BOUNDS[bucket]) bucket++;
+            buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+            count_.fetch_add(1, std::memory_order_relaxed);
+            sum_.fetch_add(us, std::memory_order_relaxed);
+            if (us > max_.load(std::memory_order_relaxed)) max_.store(us, std::memory_order_relaxed);
+        }
+        void reset() {
+            for (auto &bucket : buckets_) bucket.store(0, std::memory_order_relaxed);
+            count_.store(0, std::memory_order_relaxed);
+            sum_.store(0, std::memory_order_relaxed);
+            max_.store(0, std::memory_order_relaxed);
+        }
+        [[nodiscard]] uint32_t bucket(const size_t i) const { return buckets_[i].load(std::memory_order_relaxed); }
+        [[nodiscard]] uint32_t count() const { return count_.load(std::memory_order_relaxed); }
+        [[nodiscard]] uint32_t sum() const { return sum_.load(std::memory_order_relaxed); } // µs, wraps after ~71 min
+        [[nodiscard]] uint32_t max() const { return max_.load(std::memory_order_relaxed); }
+    private:
+        std::atomic<uint32_t> buckets_[BUCKETS] = {};
+        std::atomic<uint32_t> count_{0};
+        std::atomic<uint32_t> sum_{0};
+        std::atomic<uint32_t> max_{0};
+    };
+
+    /* ------ Times its own lifetime into a histogram ------ */
+    class Scope {
+    public:
+        explicit Scope(Histogram &histogram) : histogram_(histogram), start_(hal::cycles()) {}
+        ~Scope() { histogram_.record((hal::cycles() - start_) / hal::cyclesPerMicro()); }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    private:
+        Histogram &histogram_;
+        const uint32_t start_;
+    };
+
+    /* ------ One histogram as a Prometheus metric family member, labelled probe="<name>" ------ */
+    inline void writePrometheus(Print &out, const char *metric, const char *probe, const Histogram &histogram) {
+        uint32_t cumulative = 0;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            cumulative += histogram.bucket(i);
+            out.print(metric); out.print("_bucket{probe=\""); out.print(probe); out.print("\",le=\"");
+            if (i < BUCKETS - 1) out.print(BOUNDS[i]);
+            else out.print("+Inf");
+            out.print("\"} "); out.print(cumulative); out.print('\n');
+        }
+        out.print(metric); out.print("_sum{probe=\""); out.print(probe); out.print("\"} "); out.print(histogram.sum()); out.print('\n');
+        out.print(metric); out.print("_count{probe=\""); out.print(probe); out.print("\"} "); out.print(cumulative); out.print('\n');
+    }
+} // namespace metrics
@@ -0,0 +1,72 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Fixed-capacity, lock-free multi-producer/single-consumer ring buffer, for when more than one task or timer
+ *  callback pushes (see 'SpscRing.h' for the single-producer case). Producers claim a slot by advancing the head with
+ *  a compare-and-swap, copy the item in, then publish it through the slot's sequence number; the one consumer pops
+ *  slots in order once they are published. Nobody ever blocks or enters a critical section.
+ *      >> When the ring is full, push() refuses the new item and counts an overrun rather than waiting.
+ *      >> A producer preempted between claiming and publishing its slot holds back the consumer (not other
+ *         producers) until it resumes, so pop() may report empty while later slots are already published.
+ *      >> The capacity must be a power of two so indices wrap with a mask.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+template <typename T, size_t N>
+class MpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "MpscRing capacity must be a power of two");
+public:
+    static constexpr size_t CAPACITY = N;
+    MpscRing() {
+        for (size_t i = 0; i < N; i++) cells_[i].sequence.store(static_cast<uint32_t>(i), std::memory_order_relaxed);
+    }
+    // ------ Producer side (any number of tasks) ------
+    bool push(const T &item) {                                  // Returns false (and counts an overrun) if full
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &cells_[head & MASK];
+            const auto lag = static_cast<int32_t>(cell->sequence.load(std::memory_order_acquire) - head);
+            if (lag == 0) {                                     // free: try to claim it
+                if (head_.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) break;
+            } else if (lag < 0) {                               // still holds an item from the last lap
+                overruns_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {                                            // another producer claimed it first
+                head = head_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->item = item;
+        cell->sequence.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    // ------ Consumer side (one task) ------
+    bool pop(T &item) {                                         // Returns false if the oldest slot isn't published
+        const uint32_t tail = tail_.load(std::memory_order_relaxed);
+        Cell &cell = cells_[tail & MASK];
+        if (cell.sequence.load(std::memory_order_acquire) != tail + 1) return false;
+        item = cell.item;
+        cell.sequence.store(tail + N, std::memory_order_release);
+        tail_.store(tail + 1, std::memory_order_relaxed);
+        return true;
+    }
+    // ------ Either side ------
+    [[nodiscard]] uint32_t overruns() const { return overruns_.load(std::memory_order_relaxed); }
+private:
+    static constexpr uint32_t MASK = N - 1;
+    struct Cell {
+        std::atomic<uint32_t> sequence;                         // index: free, index + 1: published
+        T item;
+    };
+    Cell cells_[N];
+    std::atomic<uint32_t> head_{0};                             // Next slot to claim (shared by producers)
+    std::atomic<uint32_t> tail_{0};                             // Next slot to read (consumer-owned)
+    std::atomic<uint32_t> overruns_{0};                         // Items refused because the ring was full
+};
@@ -0,0 +1,70 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Fixed-capacity, lock-free single-producer/single-consumer ring buffer. One side (e.g., a timer callback) pushes,
+ *  the other (e.g., the loop) pops, and neither ever blocks or enters a critical section. The head index is only
+ *  written by the producer and the tail index only by the consumer, so two atomics with acquire/release ordering
+ *  are all the synchronization needed.
+ *      >> When the ring is full, push() refuses the new item and counts an overrun rather than overwriting data
+ *         the consumer may be reading.
+ *      >> The capacity must be a power of two so indices wrap with a mask.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+public:
+    static constexpr size_t CAPACITY = N;
+    // ------ Producer side ------
+    bool push(const T &item) {                                  // Returns false (and counts an overrun) if full
+        const uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= N) {
+            overruns_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        buffer_[head & MASK] = item;
+        head_.store(head + 1, std::memory_order_release);
+        if (const uint32_t depth = head + 1 - tail_.load(std::memory_order_relaxed);
+            depth > highWater_.load(std::memory_order_relaxed)) {
+            highWater_.store(depth, std::memory_order_relaxed);
+        }
+        return true;
+    }
+    // ------ Consumer side ------
+    bool pop(T &item) {                                         // Returns false if empty
+        const uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) return false;
+        item = buffer_[tail & MASK];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    void clear() {                                              // Consumer side: drop everything queued so far
+        tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+    }
+    // ------ Either side ------
+    /* Also read by tasks that are neither side (e.g. a gauge). tail_ is loaded first, so the head_ loaded after it is
+     * never behind it; pushes and pops in between can only overstate the depth, hence the clamp. */
+    [[nodiscard]] size_t size() const {
+        const uint32_t tail = tail_.load(std::memory_order_acquire);
+        const uint32_t used = head_.load(std::memory_order_acquire) - tail;
+        return used < N ? used : N;
+    }
+    [[nodiscard]] bool empty() const { return size() == 0; }
+    [[nodiscard]] uint32_t overruns() const { return overruns_.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint32_t highWater() const { return highWater_.load(std::memory_order_relaxed); }
+private:
+    static constexpr uint32_t MASK = N - 1;
+    T buffer_[N];
+    std::atomic<uint32_t> head_{0};                             // Next slot to write (producer-owned)
+    std::atomic<uint32_t> tail_{0};                             // Next slot to read (consumer-owned)
+    std::atomic<uint32_t> overruns_{0};                         // Items refused because the ring was full
+    std::atomic<uint32_t> highWater_{0};                        // Deepest the ring has been
+};
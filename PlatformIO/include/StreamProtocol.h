@@ -0,0 +1,149 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Binary framing for streamed sensor data. A client opts in by sending
+ *      {"dev":"STREAM","req":"SET","attr":"FORMAT","val":"BINARY"}
+ *  after which streamed data arrives as binary WebSocket messages instead of JSON. The JSON control path (GET/SET)
+ *  is unchanged either way.
+ *
+ *  The bridge coalesces everything produced during one loop() pass (and up to the send-rate cap) into one batch
+ *  message per client (see WebSocketBridge::flushTelemetry()).
+ *
+ *  Batch layout (little-endian, 5 + 29 × count bytes):
+ *      offset  size  field
+ *      0       1     type        BATCH (0xF2)
+ *      1       1     count       number of flex records that follow
+ *      2       1     flags       bit 0 (HAS_SERVO) set if the servo angle below is new
+ *      3       2     servo       int16 servo angle (º), only meaningful with HAS_SERVO
+ *      5       29×n  records     one flex record per frame:
+ *          +0      1     mask        bit i set if channel i (FLEX_{i+2}) was sampled
+ *          +1      4     sequence    frame counter (gaps mean dropped frames)
+ *          +5      8     timestamp   hal::micros() at acquisition (µs)
+ *          +13     8     readings    4 × uint16 ADC readings, 0 for unsampled channels
+ *          +21     8     angles      4 × int16 calibrated flex angles (0.01º), -32768 (NO_ANGLE) for unsampled or
+ *                                    uncalibrated channels (see 'FlexCalibration.h')
+ *  Compared with four ~40-byte JSON messages per tick, a record is more than 5× smaller, and the batch header and
+ *  WebSocket header are paid once per message instead of once per reading.
+ *  script.js (WSClient._onBinary) decodes it with a DataView; keep the two in sync.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include "FlexSensorArray.h"
+
+namespace stream {
+    /* ------ Stream formats a client can negotiate ------ */
+    enum class Format : uint8_t {
+        JSON,                                                   // Default: one JSON BATCH text message per send
+        BINARY,                                                 // One packed binary BATCH message per send
+        INVALID_FORMAT
+    };
+    inline const char *formatString(const Format format) {
+        switch (format) {
+            case Format::JSON: return "JSON";
+            case Format::BINARY: return "BINARY";
+            default: return "INVALID";
+        }
+    }
+    inline Format formatFromString(const char *format) {
+        if (format == nullptr) return Format::INVALID_FORMAT;
+        if (strcmp(format, "JSON") == 0) return Format::JSON;
+        if (strcmp(format, "BINARY") == 0) return Format::BINARY;
+        return Format::INVALID_FORMAT;
+    }
+
+    /* ------ Streams a client can subscribe to (bitmask) ------
+     * Set with {"dev":"STREAM","req":"SET","attr":"SUBSCRIBE","val":"FLEX,SERVO,CONFIG"}; an empty string subscribes to
+     * nothing. New clients start subscribed to everything.
+     */
+    enum Subscription : uint8_t {
+        FLEX = 1u << 0,                                         // Flex frames in BATCH messages
+        SERVO = 1u << 1,                                        // Servo angle in BATCH messages
+        CONFIG = 1u << 2,                                       // Attribute changes made by other clients
+        ALL = FLEX | SERVO | CONFIG
+    };
+    constexpr const char *SUBSCRIPTION_NAMES[] = {"FLEX", "SERVO", "CONFIG"};
+    /* Parse a comma-separated list of stream names. Returns false (leaving mask untouched) on an unknown name. */
+    inline bool parseSubscriptions(const char *list, uint8_t &mask) {
+        if (list == nullptr) return false;
+        uint8_t parsed = 0;
+        while (*list != '\0') {
+            const char *end = strchr(list, ',');
+            const size_t len = end != nullptr ? static_cast<size_t>(end - list) : strlen(list);
+            bool known = false;
+            for (size_t i = 0; i < sizeof(SUBSCRIPTION_NAMES) / sizeof(*SUBSCRIPTION_NAMES); i++) {
+                if (strlen(SUBSCRIPTION_NAMES[i]) == len && strncmp(SUBSCRIPTION_NAMES[i], list, len) == 0) {
+                    parsed |= 1u << i;
+                    known = true;
+                }
+            }
+            if (!known) return false;
+            list += len;
+            if (*list == ',') list++;
+        }
+        mask = parsed;
+        return true;
+    }
+    /* Write a mask as a comma-separated list into out (at least 18 bytes). Returns out. */
+    inline const char *subscriptionString(const uint8_t mask, char *out) {
+        char *p = out;
+        for (size_t i = 0; i < sizeof(SUBSCRIPTION_NAMES) / sizeof(*SUBSCRIPTION_NAMES); i++) {
+            if (!(mask & (1u << i))) continue;
+            if (p != out) *p++ = ',';
+            strcpy(p, SUBSCRIPTION_NAMES[i]);
+            p += strlen(p);
+        }
+        *p = '\0';
+        return out;
+    }
+
+    /* ------ Message type tags (first byte of every binary message) ------ */
+    constexpr uint8_t BATCH = 0xF2;
+    /* ------ Batch flags ------ */
+    constexpr uint8_t HAS_SERVO = 1u << 0;
+
+    constexpr size_t BATCH_HEADER_SIZE = 1 + 1 + 1 + 2;
+    constexpr size_t FLEX_RECORD_SIZE = 1 + 4 + 8 + 2 * FlexSensorArray::SIZE + 2 * FlexSensorArray::SIZE;
+    constexpr size_t batchSize(const size_t count) { return BATCH_HEADER_SIZE + FLEX_RECORD_SIZE * count; }
+
+    /* ------ Little-endian field writers ------ */
+    inline uint8_t *put16(uint8_t *p, const uint16_t v) {
+        p[0] = static_cast<uint8_t>(v);
+        p[1] = static_cast<uint8_t>(v >> 8);
+        return p + 2;
+    }
+    inline uint8_t *put32(uint8_t *p, const uint32_t v) {
+        return put16(put16(p, static_cast<uint16_t>(v)), static_cast<uint16_t>(v >> 16));
+    }
+    inline uint8_t *put64(uint8_t *p, const uint64_t v) {
+        return put32(put32(p, static_cast<uint32_t>(v)), static_cast<uint32_t>(v >> 32));
+    }
+
+    /* ------ Encode one flex record at p. Returns the position after it. ------ */
+    inline uint8_t *putFlexRecord(uint8_t *p, const FlexSensorArray::Frame &frame) {
+        *p++ = frame.mask;
+        p = put32(p, frame.sequence);
+        p = put64(p, frame.timestamp);
+        for (const uint16_t reading : frame.readings) p = put16(p, reading);
+        for (const int16_t angle : frame.angles) p = put16(p, static_cast<uint16_t>(angle));
+        return p;
+    }
+
+    /* ------ Encode a whole batch into out (at least batchSize(count) bytes). Returns the bytes written. ------
+     * count must fit in a byte. A negative servo angle means "no new angle". Clients not subscribed to FLEX get a
+     * count of 0, and clients not subscribed to SERVO get no angle.
+     */
+    inline size_t encodeBatch(const FlexSensorArray::Frame *frames, const size_t count, const int servo, uint8_t *out) {
+        uint8_t *p = out;
+        *p++ = BATCH;
+        *p++ = static_cast<uint8_t>(count);
+        *p++ = servo >= 0 ? HAS_SERVO : 0;
+        p = put16(p, static_cast<uint16_t>(servo >= 0 ? servo : 0));
+        for (size_t i = 0; i < count; i++) p = putFlexRecord(p, frames[i]);
+        return static_cast<size_t>(p - out);
+    }
+} // namespace stream
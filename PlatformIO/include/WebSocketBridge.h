@@ -9,14 +9,26 @@
 #pragma once
 #include <Arduino.h>
 #include <WiFi.h>
-#include <queue>                // Standard C++ queue library–queueing requests (FIFO)
+#include <atomic>               // Client table shared with the AsyncTCP task
+#include <climits>              // Bounds in the command table
+#include <mutex>                // Device lock shared by the tasks
 #include <ArduinoJson.h>        // JSON parsing library
 #include <ESPAsyncWebServer.h>  // Web server library
 #include <SPIFFS.h>             // File system library
 // Custom classes
 #include "SerialStream.h"       // Serial stream header—easier Serial monitoring/debugging
 #include "ServoController.h"    // Servo controller class
-#include "FlexSensor.h"         // Flex sensor class
+#include "FlexSensorArray.h"    // Flex sensor sampling engine
+#include "StreamProtocol.h"     // Binary stream framing
+#include "SpscRing.h"           // Frame queue from the control task to the network task
+#include "MessagePool.h"        // Preallocated request slots
+#include "CommandTable.h"       // Compile-time minimal perfect hash for the command table
+#include "JsonArena.h"          // Fixed arenas backing the JSON documents
+#include "JsonWriter.h"         // Direct writer for the streamed JSON batch
+#include "Hal.h"                // Hardware abstraction (clock)
+#include "Metrics.h"            // Latency histograms for /metrics and STATS
+#include "TaskMonitor.h"        // Per-task CPU load for /metrics and TASKS
+#include "AssistController.h"   // On-device flex -> servo control
 // Use arduino board mapping
 #ifndef BOARD_HAS_PIN_REMAP
     #define BOARD_HAS_PIN_REMAP
@@ -25,6 +37,7 @@
  *  Class for bridging the JSON commands to a device, serving web controller, and
  *  managing the Wi-Fi station. Encapsulates all device functionality. All the main.cpp
  *  file needs to do is include the class, call the setup() method, and call the loop() method.
+ *  The work itself runs in two tasks setup() starts (see TASKS below); loop() just retires the Arduino loop task.
  *  -----!! WARNING !!-----
  *  The setup() method may throw an exception if SPIFFS fails. Make sure to nest the setup() in a
  *  try-catch. Ex.:
@@ -34,7 +47,7 @@
  *                       try {
  *                           ws.setup();
  *                       } catch (...) {
- *                           sr::out << "Failed to start WebSocket server. " << sr::endl;
+ *                           sr::error << "Failed to start WebSocket server. " << sr::endl;
  *                           esp_deep_sleep_start();
  *                       }
  *                   }
@@ -45,23 +58,23 @@ public:
     WebSocketBridge();
     // =======================================================================================
     //                                  Public methods
-    void setup();       // Call once in setup()
-    void loop();        // Place once in loop()
+    void setup();       // Call once in setup(). Starts the control and network tasks.
+    void loop();        // Place once in loop(). Deletes the Arduino loop task; the tasks do the work.
+#ifndef ARDUINO
+    // =======================================================================================
+    //                                  Access for the native benchmarks
+    struct CommandKey {
+        const char *dev;
+        const char *attr;
+    };
+    static size_t commandKeys(CommandKey *keys, size_t capacity); // Every row's (dev, attr) in table order. Returns the row count.
+    static bool hasCommand(const char *dev, const char *attr);    // The lookup handleReceived() does.
+    size_t jsonBatch(const FlexSensorArray::Frame *frames,        // The JSON batch flushTelemetry() would send for these
+                     size_t count, int servo, const char *&text); // frames (at most BATCH_CAPACITY). Returns its length.
+#endif
 private:
     // =======================================================================================
     //                                  Private types
-    /* ------ DEVICE TYPES ------
-     * An enumeration defining types of devices.
-     */
-    enum class Device {
-        Servo,              // Servo motor
-        Flex,               // Represents static flex-sensor properties (applies to all)
-        Flex_2,             // Index flex sensor
-        Flex_3,             // Middle flex sensor
-        Flex_4,             // Ring flex sensor
-        Flex_5,             // Pinky flex sensor
-        INVALID_DEV         // Not a valid device
-    };
     // Method types
     /* ------ METHOD TYPES ------
      * Only get/set methods permitted for various attributes of sensors/servos.
@@ -72,43 +85,6 @@ private:
         INVALID_METHOD      // Not a valid method
     };
 
-    /* ------ SERVO MOTOR ATTRIBUTES ------
-     * These are used to modify properties of the servo motor, providing flexibility with
-     * various motor types. Refer to the data sheet to specify PWM signal constrains. The
-     * default values are for a 270º servo w/ 270º rotation @ 500 – 2500 µs.
-     */
-    enum class ServoAttr {
-        AngleStep,   /* <int> */                        // Angle increment (º) per invocation of timer.
-        TimeDelayUS, /* <unsigned long> */              // Time delay (µs) between angle increments.
-        MinPWM,      /* <unsigned long> */              // Minimum pulse-width (µs) of PWM signal (can be found in servo's data sheet).
-        MaxPWM,      /* <unsigned long> */              // Maximum pulse-width (µs) of PWM signal (also in data sheet).
-        Position,    /* <unsigned long> */              // Angular position of motor (º)
-        Pin,         /* <uint8_t> */                    // Set pin which motor is connected to.
-        Actuate,     /* <bool> */                       // Enable/disable actuation of servo when in a controlled-speed state.
-        StartAngle,  /* <unsigned int> */               // The angle which the motor starts actuation during a controlled-speed state.
-        StopAngle,   /* <unsigned int> */               // The angle which the motor stops actuation during controlled motion.
-        Motion,      /* <ServoController::Motion> */    // The motion mode of servo (LOOP/SWEEP/ONE_SHOT) (see 'ServoController.h').
-        MaxAngle,    /* <unsigned int> */               // The maximum angle used for duty-cycle calculation.
-        INVALID_SERVO_ATTR                              // Default, invalid value.
-    };
-    /* ------ STATIC FLEX SENSOR ATTRIBUTES ------
-     * These values are used to modify attributes belonging to the flex-sensor class itself, as they're
-     * a property of the class, not any particular flex sensor device. For example, the sampling rate for
-     * a flex-sensor device should be the same for all devices (unless you'd like to change it).
-     */
-    enum class FlexAttr {
-        SampleRate,  /* <uint64_t> */                   // The sampling interval for which the flag indicating to acquire a new reading is invoked.
-        Start,       /* value not required */           // Enable sampling.
-        Stop,        /* value not required */           // Disable sampling.
-        INVALID_FLEX_ATTR                               // Invalid value for a static flex-sensor attribute.
-    };
-    /* ------ INSTANCE-BASED FLEX SENSOR ATTRIBUTES ------
-     * For now, only the pin for which the sensor's attached is an instance-based attribute which can be modified.
-     */
-    enum class FlexNAttr {
-        Pin,                                            // Pin which to connect the sensor to. Must be a valid ADC pin.
-        INVALID_FLEX_N_ATTR                             // Invalid value for an instance of a flex sensor.
-    };
     /* ------ STATUS CODES ------
      * These are the codes sent to the client upon set requests, indicating whether their set-attribute
      * call was successful or not. These aren't included in responses to get requests as they represent
@@ -118,6 +94,37 @@ private:
         OK,                                             // Successful set request.
         ERROR                                           // Failed set request.
     };
+    /* ------ COMMAND TABLE ------
+     * Every (dev, attr) pair the bridge understands is one row of a table (WebSocketBridge::Commands, defined in
+     * WebSocketBridge.cpp). A row binds the getter, the setter, how the "val" field of a SET is coerced, and the range
+     * it must fall in. handleReceived() finds the row through a perfect hash built at compile time (see 'CommandTable.h'),
+     * so a new attribute is one new row.
+     */
+    enum class Coerce : uint8_t {
+        None,                                           // No value needed (FLEX START/STOP).
+        Int,                                            // Number (truncated to an integer) within [min, max].
+        Bool,                                           // true/false.
+        Text,                                           // String.
+        Pin,                                            // Pin number within [min, max], or false/"false" to disconnect.
+    };
+    struct Arg {                                        // "val" after coercion.
+        long number;                                    // Int, Bool (0/1) and Pin values.
+        const char *text;                               // Text values.
+        bool detach;                                    // Pin values of false/"false".
+    };
+    struct Command {
+        const char *dev;                                // Device name ("SERVO", "FLEX", "FLEX_n", "STREAM", "HEAP", "LOG", "STATS", "TASKS" or "CONTROL").
+        const char *attr;                               // Attribute name.
+        Coerce type;                                    // Coercion of "val" for SET requests.
+        long min;                                       // Inclusive bounds for Int/Pin values.
+        long max;
+        void (*get)(WebSocketBridge &, const Command &, uint32_t); // Composes the current value for a client id as reply_ (nullptr if write-only).
+        Status (*set)(WebSocketBridge &, const Arg &);  // Applies a coerced value (nullptr if read-only).
+        bool unlocked = false;                          // The getter reads no device, so it runs without devices_.
+    };
+    struct Commands;                                    // The table and its index (see WebSocketBridge.cpp).
+    struct Stats;                                       // Counters reported by /metrics and STATS (see WebSocketBridge.cpp).
+    using DeviceLock = std::lock_guard<std::mutex>;     // Holds devices_ for a scope.
     // =======================================================================================
     //                                  Private fields
     /* ------ SERVER/CLIENT INTERACTION -------
@@ -131,20 +138,135 @@ private:
     AsyncWebSocket       ws_;                           // Instance of an asynchronous web-socket.
     AsyncWebServer      server_;                        // Instance of an asynchronous web server.
     /* ------ DATA FORMATTING/MANAGING ------
-     * Two JSON documents declared class-scoped to reduce heap fragmentation on an embedded system like the Nano ESP32. This is
-     * due to the latest ArduinoJson library version dynamically allocating everything.
+     * Two JSON documents declared class-scoped to reduce heap fragmentation on an embedded system like the Nano ESP32. The
+     * latest ArduinoJson library version dynamically allocates everything, so each document allocates from its own fixed
+     * arena instead of the heap (see 'JsonArena.h'). A message too big for its arena fails to parse/build (NoMemory)
+     * rather than growing the heap. The arenas must be declared before the documents using them.
      */
+    static constexpr size_t IN_ARENA_SIZE = 2048;       // Bytes for one parsed request. ArduinoJson allocates variants
+    static constexpr size_t OUT_ARENA_SIZE = 2048;      // in 1 KB pools on 32-bit targets, so neither can go lower.
+    static constexpr uint8_t CONFIG_VERSION = 1;        // "ver" of the CONFIG snapshot; bump when its layout changes.
+    JsonArena<IN_ARENA_SIZE> inArena_;                  // Backs inBuffer.
+    JsonArena<OUT_ARENA_SIZE> outArena_;                // Backs outBuffer.
     JsonDocument inBuffer;                              // Store input data.
     JsonDocument outBuffer;                             // Store output data.
-    std::queue<std::string> received;                   // Queued std::strings representing received, unparsed data.
+    /* ------ REPLIES ------
+     * A getter runs under devices_ but never sends: it composes its reply (into replyText_, or txText_ for the long
+     * STATS/TASKS messages) and reply_ points at it. The caller sends reply_ once the lock is released, so AsyncTCP
+     * queueing a frame never holds up the control task. Getters marked unlocked (STATS/TASKS, which only read
+     * atomics and their own locks) don't take devices_ at all, so building a long message doesn't hold it either.
+     */
+    char replyText_[200];                               // GET-style replies composed by composeGetResponse().
+    const char *reply_;                                 // Composed reply (replyText_ or txText_), nullptr if none.
+    size_t replyLength_;                                // Bytes in reply_.
+    /* ------ INCOMING REQUESTS ------
+     * Requests are written straight from the AsyncTCP task into preallocated slots, handed to the network task
+     * lock-free, parsed in place, and released (see 'MessagePool.h'). Nothing is allocated per request.
+     * Fragmented messages are assembled per client in assembling_, which only the AsyncTCP task touches.
+     */
+    static constexpr size_t REQUEST_SLOTS = 8;          // Requests that may wait for the network task at once.
+    static constexpr size_t REQUEST_SIZE = 256;         // Longest accepted request (bytes); commands are < 80.
+    using Requests = MessagePool<REQUEST_SLOTS, REQUEST_SIZE>;
+    Requests requests_;                                 // Slot pool shared by the AsyncTCP and network tasks.
+    /* ------ CLIENT SESSIONS ------
+     * One session per connected client: its stream format, the streams it subscribed to, and whether it still needs
+     * the connect snapshot. Sessions are claimed/released by the AsyncTCP task on connect/disconnect and read by the
+     * network task, so each field is atomic. An id of 0 marks a free session (AsyncWebSocket ids start at 1).
+     *  >> Replies go only to the client that asked. Streamed data goes only to subscribers, and a change one client
+     *     makes is echoed to the other CONFIG subscribers, so extra dashboards cost one message each, not a broadcast
+     *     of everything.
+     */
+    static constexpr size_t MAX_CLIENTS = 8;            // Matches AsyncWebSocket's default client limit.
+    struct Session {
+        std::atomic<uint32_t> id{0};                    // Client id, 0 if free.
+        std::atomic<stream::Format> format{stream::Format::JSON}; // Negotiated stream format.
+        std::atomic<uint8_t> subscriptions{stream::ALL}; // stream::Subscription bits.
+        std::atomic<bool> needsSnapshot{false};         // Connect snapshot not sent yet.
+    };
+    Session sessions_[MAX_CLIENTS];                     // Connected clients.
+    struct Assembly {                                   // A request still arriving in fragments.
+        uint32_t client;                                // Client id, 0 if unused.
+        Requests::Slot *slot;                           // Slot being filled (nullptr if the request is being dropped).
+    };
+    Assembly assembling_[MAX_CLIENTS];                  // One in-flight request per client (AsyncTCP task only).
+    uint32_t requester_;                                // Id of the client whose request is being handled.
+    /* ------ OUTGOING TELEMETRY ------
+     * Everything streamed during a network pass (flex frames, the servo angle) is gathered here and sent as one
+     * message per client by flushTelemetry(), at most maxSendRate_ times per second. A client whose send queue
+     * already holds MAX_CLIENT_QUEUE messages is skipped for that send rather than queued further.
+     */
+    static constexpr size_t BATCH_CAPACITY = 16;        // Frames per message; a full batch is sent regardless of the rate cap.
+    static constexpr size_t MAX_CLIENT_QUEUE = 4;       // Messages a client may have queued before sends to it are skipped.
+    static constexpr uint32_t DEFAULT_MAX_SEND_RATE = 50; // Messages per second (Hz).
+    FlexSensorArray::Frame batch_[BATCH_CAPACITY];      // Frames gathered since the last send.
+    size_t batchCount_;                                 // Number of frames in batch_.
+    int pendingServo_;                                  // Servo angle not yet sent (-1 if none).
+    uint32_t maxSendRate_;                              // Cap on sends per second.
+    uint64_t lastSend_;                                 // hal::micros() of the last send (µs).
+    std::atomic<uint32_t> sendSkips_;                   // Per-client sends skipped due to backpressure (read by /metrics).
+    uint8_t txBinary_[stream::batchSize(BATCH_CAPACITY)]; // Encoded binary batch, shared by all binary clients.
+    char txText_[2048];                                 // JSON batch, shared by all JSON clients (16 frames need < 1900 bytes). Also
+                                                        // holds STATS, TASKS and the CONFIG snapshot (all network task).
     /* ------ DEVICES ------
      * Five devices total are declared—a servo motor for flexion controlling and four flex sensors, one for each
-     * finger, excluding the thumb.
+     * finger, excluding the thumb. The flex sensors are sampled together by one FlexSensorArray. Unless its mode is
+     * OFF, control_ drives the servo from each frame in the control task (see 'AssistController.h').
      */
     ServoController servo_;                             // Instance of a servo motor.
-    FlexSensor sensors[4];                              // Four flex sensors.
+    FlexSensorArray sensors_;                           // Four flex sensors, scanned as one frame per tick.
+    AssistController control_;                          // Flex -> servo control, run per frame by emitSensorFrame().
+    /* ------ TASKS ------
+     * Two FreeRTOS tasks instead of the Arduino loop, one per core:
+     *  >> control (CONTROL_CORE): servo_.loop() and sensors_.loop(), at a priority above everything networking does.
+     *     Wi-Fi and lwIP live on the other core, so a burst of traffic can't preempt it.
+     *  >> network (NETWORK_CORE, alongside Wi-Fi): requests, snapshots, client cleanup and telemetry, at AsyncTCP's
+     *     priority.
+     * Neither polls. Each blocks on its hal::Event until there is work: the control task until the sampling or servo
+     * timer leaves some, the network task until a request or connection arrives, the control task hands over
+     * telemetry, or a rate-capped batch falls due (at most CLEANUP_PERIOD apart, for cleanupClients()). A timer's
+     * work is picked up within a context switch rather than at the next 1 ms poll, and the cores sit in the idle
+     * task (waiting for an interrupt) in between.
+     * Nothing is shared between them through flags. Frames go from control to network through a lock-free queue
+     * (see 'SpscRing.h'; a full queue drops the frame and counts it) and the servo angle through a one-deep mailbox.
+     * The devices are only touched while holding devices_: the control task for each pass, the network and AsyncTCP
+     * tasks for each command's getter/setter (JSON parsing and sending stay outside it). std::mutex is a FreeRTOS
+     * mutex on the board, so it has priority inheritance and a command holding it can't be starved by the control
+     * task's priority.
+     *  >> Off the board (the simulator has one thread) setup() starts no tasks and loop() runs one pass of each.
+     */
+    static constexpr int CONTROL_CORE = 1;              // APP_CPU: acquisition and the servo only.
+    static constexpr int NETWORK_CORE = 0;              // PRO_CPU: with the Wi-Fi/lwIP tasks.
+    static constexpr uint32_t CONTROL_PRIORITY = 10;    // Above AsyncTCP (3) and the Arduino loop (1), below esp_timer (22).
+    static constexpr uint32_t NETWORK_PRIORITY = 3;     // Same as AsyncTCP, which hands it requests.
+    static constexpr uint32_t CONTROL_STACK = 4096;     // Bytes.
+    static constexpr uint32_t NETWORK_STACK = 8192;     // Bytes; JSON serialization runs on it.
+    static constexpr uint32_t CLEANUP_PERIOD = 1000;    // Longest the network task sleeps (ms).
+    static constexpr size_t FRAME_QUEUE_LENGTH = 64;    // Frames in flight from control to network (64 ms @ 1 kHz).
+    static constexpr int NO_ANGLE = -1;
+    SpscRing<FlexSensorArray::Frame, FRAME_QUEUE_LENGTH> frames_; // control -> network.
+    std::atomic<int> servoAngle_;                       // Latest servo angle not yet taken (NO_ANGLE if none), control -> network.
+    std::mutex devices_;                                // Held while servo_/sensors_ are used.
+    hal::Event controlWake_;                            // Signalled by the sampling and servo timers.
+    hal::Event networkWake_;                            // Signalled by AsyncTCP and the control task.
+    /* ------ METRICS ------
+     * Latency histograms for the hot paths (see 'Metrics.h'), each written only by the task running the probed code,
+     * plus the queue/drop/heap counters gathered in Stats. Both are served as Prometheus text on GET /metrics and as
+     * one JSON message by the STATS device, so a regression shows up as a shifted histogram, not a feeling.
+     * Per-task CPU load, stack headroom and per-core idle time are sampled by the network task (see 'TaskMonitor.h')
+     * and served the same two ways, /metrics and the TASKS device.
+     */
+    metrics::Histogram latency_[metrics::PROBES];       // Indexed by metrics::Probe.
+    TaskMonitor tasks_;                                 // Sampled once per period by networkPass().
     // =======================================================================================
     //                                  Private methods
+#ifdef ARDUINO
+    static void controlTask(void *arg);                 // Task entry points; arg is the bridge.
+    static void networkTask(void *arg);
+#endif
+    void controlPass();                                 // One pass of each task's loop.
+    void networkPass();
+    void drainTelemetry();                              // Move queued frames/angle into the pending batch.
+    uint32_t networkTimeout() const;                    // How long the network task may sleep (ms), at most a task sample period.
     /* ------ Callback for websocket-related events ------
      *  This method handles events where,
      *      - a client connects -> call to send initial data,
@@ -160,19 +282,29 @@ private:
                    uint8_t *data,                       // Pointer to the data array received.
                    size_t len) ;                        // Length of the data array.
     /* ------ Callback for emitting servo position readings ------
-     * This method is called when the servo's angle changes but only angle-changes invoked by the esp_timer
-     * governing the servo's speed.
+     * This method is called (control task) when the servo's angle changes. The angle is queued for the network
+     * task, which holds it until the next flushTelemetry() so it rides along with that pass's flex frames.
      */
     void emitServoAngle(
         int angle);                                     // New angle reading
 
-    /* ------ Callback for emitting a sensor's ADC reading ------
-     * This method is invoked after the sampling esp_timer flags for a new reading, and the
-     * reading is collected. Actual invoking happens in the sensor's loop method.
+    /* ------ Callback for emitting a frame of sensor readings ------
+     * This method is invoked (control task) once per frame the FlexSensorArray produces. Unless control_ is
+     * OFF, the servo is moved to the setpoint it computes from the frame first, so it follows the fingers
+     * within one sample period. The frame is then queued for the network task, which adds it to the pending batch.
+     */
+    void emitSensorFrame(
+        const FlexSensorArray::Frame &frame);           // Time-aligned readings of all connected sensors.
+
+    /* ------ Send the pending batch ------
+     * Called at the end of every network pass. Returns early while under the rate cap unless the batch
+     * is full, then sends each client with room the parts it subscribed to. Clients sharing a format and
+     * subscriptions share one encoding.
      */
-    void emitSensorReading(
-        uint16_t value,                                 // ADC 16-bit value (0 - 4095).
-        const char* name);                              // Name of the sensor emitting reading.
+    void flushTelemetry();
+    size_t encodeJsonBatch(                             // Write the pending batch into txText_. Returns its length (0 if too big).
+        size_t count,                                   // Frames to include (0 for clients not subscribed to FLEX).
+        int servo);                                     // Servo angle to include (-1 for none).
 
     /* ------ Helper for sending an invalid request ------
      * This helper method is called throughout the parsing of the program to notify the client
@@ -181,6 +313,10 @@ private:
      */
     void sendInvalidRequest(
         AsyncWebSocketClient* client);                  // Client which made the invalid request.
+    /* ------ Helpers for the metrics ------ */
+    void writeMetrics(Print &out);                      // Every histogram and counter in the Prometheus text format.
+    size_t encodeStats();                               // The STATS message into txText_ (network task). Returns its length (0 if too big).
+    size_t encodeTasks();                               // The TASKS message into txText_ (network task). Returns its length (0 if too big).
     /* ------ Helper for sending a response from a set request ------
      * This method is called when a request to change an attribute is made.
      */
@@ -193,30 +329,57 @@ private:
      */
     void sendInvalidAttr(
         AsyncWebSocketClient *client);                  // Client making the invalid set/get request
-    /* ------ Helper for sending a response to a get request ------
+    /* ------ Helper for composing a response to a get request ------
      * The templated argument provides flexibility governed by ArduinoJson's library to
-     * convert the type into a sendable field.
+     * convert the type into a sendable field. The response becomes reply_; sendReply() sends it.
      */
     template <typename T>                               // Generic type compatible w/ ArduinoJson
-    void sendGetResponse(
+    void composeGetResponse(
         const char* device,                             // Device name as a character array (string)
         const char* attr,                               // Attribute field as a character array (string)
         const T& val);                                  // Value to send
+    void composeErrorResponse(                          // Make { dev, req: GET, attr, stat: ERROR } the reply.
+        const char *device,
+        const char *attr);
+    void composeReply(                                  // Make a message already written (e.g. into txText_) the reply.
+        const char *text,
+        size_t length);
+    void sendReply(                                     // Send reply_ (if any). Call without devices_ held. reply_ is left
+                                                        // set (broadcastChange() sends it to several clients); callers reset it.
+        AsyncWebSocketClient *client);
     /* ------ Helper for handling when a client connects ------
-     * This method sends all the initial values of all the devices as a response to a getter request.
+     * This method sends all the initial values of all the devices to the new client only, as one CONFIG message
+     * (layout in 'commands.txt'). It's called from the network task for sessions flagged on connect, since outBuffer
+     * belongs to that task.
      */
     void handleConnect(
         AsyncWebSocketClient *client);                  // Pointer to the client that connected.
 
-    Device parseDevice();                               // Method for parsing the device field in the inBuffer JSON doc.
+    /* ------ Helper for WS_EVT_DATA ------
+     *  Appends one chunk of a text message to the sender's slot, and commits the slot once the
+     *  final chunk of the final frame arrives. Runs on the AsyncTCP task.
+     */
+    void onData(
+        AsyncWebSocketClient *client,                   // Client the chunk came from.
+        const AwsFrameInfo *info,                       // Frame/message position of the chunk.
+        const uint8_t *data,                            // Chunk payload.
+        size_t len);                                    // Chunk length.
+    void dropAssembly(uint32_t id);                     // Abandon a client's partially received request.
+    /* ------ Helpers for the session table ------ */
+    void addClient(uint32_t id);                        // Open a session for a newly connected client.
+    void removeClient(uint32_t id);                     // Close a disconnected client's session.
+    Session *findClient(uint32_t id);                   // Session of a connected client (nullptr if none).
+    void sendSnapshots();                               // Send the connect snapshot to sessions still waiting for it.
+    void broadcastChange(                               // Echo an attribute a client just set to the other CONFIG subscribers.
+        const Command &command);
+
     Method parseMethod();                               // Method for parsing the request field in the inBuffer JSON doc.
-    ServoAttr parseServoAttr();                         // Method for parsing servo attributes from the inBuffer.
-    FlexAttr parseFlexAttr();                           // Method for parsing static flex sensor attributes from the inBuffer.
-    FlexNAttr parseFlexNAttr();                         // Helper method for parsing instance-based flex sensor attributes.
     /* ------ Helper method for parsing queued data ------
-     * This is the monster method that parses all the fields in the inBuffer JsonDocument. It is a nasty method
-     * but optimizes performance by performing c-string operations, tree search patterns, and switch statements.
+     * Deserializes a request, looks its (dev, attr) pair up in the command table, and runs the row's getter, or
+     * coerces/validates "val" and runs its setter. Replies go to the requesting client.
      */
     void handleReceived(
-        const char* message);
+        uint32_t clientId,                              // Id of the client that sent the message.
+        char* message,                                  // Null-terminated message, parsed in place.
+        size_t length);                                 // Length of the message.
 };
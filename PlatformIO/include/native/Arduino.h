@@ -0,0 +1,50 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Native (simulator) stand-in for <Arduino.h>. Only found by the `native` environment (-I include/native), and only
+ *  provides what the classes use outside of the HAL: pin names, map(), F(), Serial, the delays and ESP.
+ *      >> Pin numbers follow the Nano ESP32's Arduino numbering (D0 – D13, then A0 – A7).
+ *      >> delay()/delayMicroseconds() advance the simulated clock (firing any timers that fall due) instead of
+ *         sleeping, and millis()/micros() read it.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
+#include "Print.h"
+#include "HardwareSerial.h"
+#include "Sim.h"
+
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+#define PROGMEM
+
+enum : uint8_t { D0 = 0, D1, D2, D3, D4, D5, D6, D7, D8, D9, D10, D11, D12, D13 };
+enum : uint8_t { A0 = 17, A1, A2, A3, A4, A5, A6, A7 };
+
+using std::abs;
+
+inline long map(const long x, const long inMin, const long inMax, const long outMin, const long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+template <typename T>
+T constrain(const T x, const T low, const T high) { return x < low ? low : (x > high ? high : x); }
+
+inline void delayMicroseconds(const uint32_t us) { sim::advance(us); }
+inline void delay(const uint32_t ms) { sim::advance(static_cast<uint64_t>(ms) * 1000); }
+inline unsigned long micros() { return static_cast<unsigned long>(sim::now()); }
+inline unsigned long millis() { return static_cast<unsigned long>(sim::now() / 1000); }
+
+inline int esp_reset_reason() { return 1; }                     // ESP_RST_POWERON
+struct EspClass {                                               // The host's heap isn't the board's, so report none
+    uint32_t getFreeHeap() { return 0; }
+    uint32_t getMinFreeHeap() { return 0; }
+    uint32_t getMaxAllocHeap() { return 0; }
+    uint32_t getHeapSize() { return 0; }
+};
+inline EspClass ESP;
@@ -0,0 +1,36 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Benchmarks run by the `native` environment (see 'src/native/main.cpp'). Each prints one line of key=value results
+ *  per configuration on stdout; everything the classes themselves print goes to stderr. The checks among them return
+ *  false (and end their lines with FAIL) when a result is wrong, and the program then exits with 1.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace bench {
+    constexpr uint64_t INTERVALS[] = {1000, 2000, 5000, 10000, 100000}; // Sampling intervals every benchmark covers (µs)
+
+    void sampling(uint64_t seconds, uint32_t jitter);           // FlexSensorArray/ServoController against the simulator
+    void endToEnd(uint64_t seconds, uint32_t jitter);           // ADC read -> WebSocketBridge -> headless client decode
+    bool filter(uint64_t seconds);                              // 'FlexFilter.h' kernels against a double reference. False if off by > 1 LSB
+    void logging(uint64_t seconds);                             // 'SerialStream.h' text, compiled-out and deferred forms
+    bool ring();                                                // 'SpscRing.h' across two threads. False if it failed
+    bool dispatch();                                            // 'CommandTable.h' lookup against strcmp. False if they disagree
+    bool json();                                                // 'JsonWriter.h' batch against JsonDocument. False if they differ
+    bool profile();                                             // 'MotionProfile.h' endpoints and limits. False if one is off
+
+    /* ------ p-th percentile (0 – 1) by rank; reorders values ------ */
+    inline uint64_t percentile(std::vector<uint64_t> &values, const double p) {
+        if (values.empty()) return 0;
+        const auto rank = static_cast<size_t>(p * static_cast<double>(values.size() - 1));
+        std::nth_element(values.begin(), values.begin() + static_cast<long>(rank), values.end());
+        return values[rank];
+    }
+} // namespace bench
@@ -0,0 +1,235 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Native (simulator) stand-in for <ESPAsyncWebServer.h>: the subset of AsyncWebServer/AsyncWebSocket the bridge uses,
+ *  backed by an in-process link instead of TCP. Messages the bridge sends are queued on the client, stamped with the
+ *  simulated time they were enqueued, and handed to the client's onMessage hook once the link has carried them.
+ *      >> The link model is per client: a message starts transmitting when the previous one has finished, takes
+ *         size / bytesPerSecond to transmit, and arrives latencyUs after that. queueLen() counts messages that haven't
+ *         arrived yet, the same quantity the bridge's backpressure check reads on the board.
+ *      >> The simulator side (connect(), send(), disconnect(), deliver()) is what a headless client drives. Events
+ *         are raised synchronously on the caller's thread, where the board raises them from the AsyncTCP task.
+ *      >> HTTP is limited to on() routes, which get() runs directly and returns the body of (serveStatic() and
+ *         onNotFound() are accepted and ignored).
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+#include "Hal.h"
+
+typedef enum { WS_EVT_CONNECT, WS_EVT_DISCONNECT, WS_EVT_PING, WS_EVT_PONG, WS_EVT_ERROR, WS_EVT_DATA } AwsEventType;
+#define WS_CONTINUATION 0x00
+#define WS_TEXT 0x01
+#define WS_BINARY 0x02
+
+typedef struct {
+    uint8_t message_opcode;
+    uint32_t num;
+    uint8_t final;
+    uint8_t masked;
+    uint8_t opcode;
+    uint64_t len;
+    uint8_t mask[4];
+    uint64_t index;
+} AwsFrameInfo;
+
+class AsyncWebSocket;
+
+/* ------ One message on its way from the bridge to a client ------ */
+struct WsMessage {
+    bool binary;
+    std::vector<uint8_t> data;
+    uint64_t queuedAt;                                          // Simulated time the bridge enqueued it (µs)
+    uint64_t deliverAt;                                         // Simulated time it reaches the client (µs)
+};
+
+class AsyncWebSocketClient {
+public:
+    AsyncWebSocketClient(const uint32_t id, AsyncWebSocket *server) : id_(id), server_(server), linkFreeAt_(0) {}
+    // ------ Bridge side ------
+    uint32_t id() const { return id_; }
+    void text(const char *message, const size_t len) { enqueue(false, reinterpret_cast<const uint8_t *>(message), len); }
+    void text(const char *message) { text(message, strlen(message)); }
+    void binary(const uint8_t *message, const size_t len) { enqueue(true, message, len); }
+    void binary(const char *message, const size_t len) { binary(reinterpret_cast<const uint8_t *>(message), len); }
+    size_t queueLen() const { return queue_.size(); }
+    bool queueIsFull() const { return false; }
+    bool canSend() const { return true; }
+    AsyncWebSocket *server() { return server_; }
+    // ------ Simulator side ------
+    std::function<void(const WsMessage &)> onMessage;           // Headless client's receive hook
+    void deliver(const uint64_t now) {                          // Hand over every message that has arrived by now
+        while (!queue_.empty() && queue_.front().deliverAt <= now) {
+            const WsMessage message = std::move(queue_.front());
+            queue_.pop_front();
+            if (onMessage) onMessage(message);
+        }
+    }
+private:
+    void enqueue(bool binary, const uint8_t *data, size_t len);
+    uint32_t id_;
+    AsyncWebSocket *server_;
+    uint64_t linkFreeAt_;                                       // When the link finishes the last queued message
+    std::deque<WsMessage> queue_;
+};
+
+class AsyncWebHandler {};
+
+enum WebRequestMethod { HTTP_GET = 0b00000001, HTTP_POST = 0b00000010 };
+
+class AsyncWebServerResponse {
+public:
+    virtual ~AsyncWebServerResponse() = default;
+    std::string body;
+};
+class AsyncResponseStream : public Print, public AsyncWebServerResponse { // Print into the response body
+public:
+    size_t write(const uint8_t c) override { body.push_back(static_cast<char>(c)); return 1; }
+    size_t write(const uint8_t *buffer, const size_t size) override {
+        body.append(reinterpret_cast<const char *>(buffer), size);
+        return size;
+    }
+    using Print::write;
+};
+
+class AsyncWebServerRequest {
+public:
+    void send(int) {}
+    void send(int, const char *, const char *body) { body_ = body; }
+    void send(AsyncWebServerResponse *response) {
+        body_ = response->body;
+        delete response;
+    }
+    AsyncResponseStream *beginResponseStream(const char *, size_t = 1460) { return new AsyncResponseStream(); }
+    const std::string &body() const { return body_; }           // Simulator side: what the handler sent
+private:
+    std::string body_;
+};
+typedef std::function<void(AsyncWebServerRequest *)> ArRequestHandlerFunction;
+
+typedef std::function<void(AsyncWebSocket *, AsyncWebSocketClient *, AwsEventType, void *, uint8_t *, size_t)> AwsEventHandler;
+
+class AsyncWebSocket : public AsyncWebHandler {
+public:
+    struct Link {
+        uint32_t latencyUs;                                     // One-way propagation delay
+        uint32_t bytesPerSecond;                                // Payload rate (0 for unlimited)
+    };
+    explicit AsyncWebSocket(const char *url) : url_(url), link_{2000, 250000}, nextId_(1), enabled_(true) {
+        registry().push_back(this);
+    }
+    ~AsyncWebSocket() {
+        auto &sockets = registry();
+        for (auto it = sockets.begin(); it != sockets.end(); ++it) {
+            if (*it == this) {
+                sockets.erase(it);
+                break;
+            }
+        }
+    }
+    // ------ Bridge side ------
+    void onEvent(AwsEventHandler handler) { handler_ = std::move(handler); }
+    void enable(const bool enable) { enabled_ = enable; }
+    void cleanupClients(uint16_t = 8) {}
+    size_t count() const { return clients_.size(); }
+    AsyncWebSocketClient *client(const uint32_t id) {
+        for (auto &c : clients_) {
+            if (c.id() == id) return &c;
+        }
+        return nullptr;
+    }
+    void pingAll() {}
+    // ------ Simulator side ------
+    static AsyncWebSocket *find(const char *url) {              // The socket the bridge registered under url
+        for (auto *socket : registry()) {
+            if (strcmp(socket->url_, url) == 0) return socket;
+        }
+        return nullptr;
+    }
+    void setLink(const Link link) { link_ = link; }
+    const Link &link() const { return link_; }
+    AsyncWebSocketClient *connect() {
+        if (!enabled_) return nullptr;
+        clients_.emplace_back(nextId_++, this);
+        AsyncWebSocketClient *c = &clients_.back();
+        if (handler_) handler_(this, c, WS_EVT_CONNECT, nullptr, nullptr, 0);
+        return c;
+    }
+    void send(AsyncWebSocketClient *c, const char *message) {   // A whole text message from the client, in one frame
+        const size_t len = strlen(message);
+        std::vector<uint8_t> data(message, message + len);
+        AwsFrameInfo info{};
+        info.message_opcode = WS_TEXT;
+        info.opcode = WS_TEXT;
+        info.final = 1;
+        info.len = len;
+        if (handler_) handler_(this, c, WS_EVT_DATA, &info, data.data(), len);
+    }
+    void disconnect(AsyncWebSocketClient *c) {
+        for (auto it = clients_.begin(); it != clients_.end(); ++it) {
+            if (&*it != c) continue;
+            if (handler_) handler_(this, c, WS_EVT_DISCONNECT, nullptr, nullptr, 0);
+            clients_.erase(it);
+            return;
+        }
+    }
+    void deliver() {
+        for (auto &c : clients_) c.deliver(hal::micros());
+    }
+private:
+    static std::vector<AsyncWebSocket *> &registry() {
+        static std::vector<AsyncWebSocket *> sockets;
+        return sockets;
+    }
+    const char *url_;
+    Link link_;
+    uint32_t nextId_;
+    bool enabled_;
+    AwsEventHandler handler_;
+    std::list<AsyncWebSocketClient> clients_;                   // list: client pointers stay valid
+};
+
+inline void AsyncWebSocketClient::enqueue(const bool binary, const uint8_t *data, const size_t len) {
+    const uint64_t now = hal::micros();
+    const AsyncWebSocket::Link &link = server_->link();
+    const uint64_t transmit = link.bytesPerSecond != 0 ? len * 1000000ULL / link.bytesPerSecond : 0;
+    linkFreeAt_ = (linkFreeAt_ > now ? linkFreeAt_ : now) + transmit;
+    queue_.push_back(WsMessage{binary, std::vector<uint8_t>(data, data + len), now, linkFreeAt_ + link.latencyUs});
+}
+
+class AsyncStaticWebHandler {
+public:
+    AsyncStaticWebHandler &setDefaultFile(const char *) { return *this; }
+};
+
+class AsyncWebServer {
+public:
+    explicit AsyncWebServer(uint16_t) {}
+    AsyncStaticWebHandler &serveStatic(const char *, fs::FS &, const char *) { return static_; }
+    void onNotFound(ArRequestHandlerFunction) {}
+    void on(const char *uri, int, ArRequestHandlerFunction handler) { routes_[uri] = std::move(handler); }
+    void addHandler(AsyncWebHandler *) {}
+    void begin() {}
+    // ------ Simulator side ------
+    std::string get(const char *uri) {                          // Body the route sends ("" if there's no route)
+        const auto route = routes_.find(uri);
+        if (route == routes_.end()) return "";
+        AsyncWebServerRequest request;
+        route->second(&request);
+        return request.body();
+    }
+private:
+    AsyncStaticWebHandler static_;
+    std::map<std::string, ArRequestHandlerFunction> routes_;
+};
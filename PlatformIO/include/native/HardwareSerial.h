@@ -0,0 +1,23 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Native (simulator) stand-in for the board's Serial. Output goes to stderr, so whatever a simulator run prints on
+ *  stdout (benchmark results) stays machine-readable.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <cstdio>
+#include "Print.h"
+
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long) {}
+    size_t write(const uint8_t c) override { return fputc(c, stderr) == EOF ? 0 : 1; }
+    size_t write(const uint8_t *buffer, const size_t size) override { return fwrite(buffer, 1, size, stderr); }
+    void flush() override { fflush(stderr); }
+    explicit operator bool() const { return true; }
+};
+inline HardwareSerial Serial;
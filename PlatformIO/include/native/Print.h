@@ -0,0 +1,50 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Native (simulator) stand-in for Arduino's Print: just the print()/println() overloads SerialStream.h relies on,
+ *  formatted the same way the core formats them, written byte-by-byte through write().
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+class __FlashStringHelper;                                      // Flash strings are ordinary strings off the board
+
+class Print {
+public:
+    virtual ~Print() = default;
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size) {
+        size_t n = 0;
+        while (n < size && write(buffer[n])) n++;
+        return n;
+    }
+    size_t write(const char *s) { return write(reinterpret_cast<const uint8_t *>(s), strlen(s)); }
+    virtual void flush() {}
+
+    size_t print(const __FlashStringHelper *s) { return print(reinterpret_cast<const char *>(s)); }
+    size_t print(const char *s) { return write(s); }
+    size_t print(const char c) { return write(static_cast<uint8_t>(c)); }
+    size_t print(const unsigned char n) { return format("%u", static_cast<unsigned>(n)); }
+    size_t print(const int n) { return format("%d", n); }
+    size_t print(const unsigned int n) { return format("%u", n); }
+    size_t print(const long n) { return format("%ld", n); }
+    size_t print(const unsigned long n) { return format("%lu", n); }
+    size_t print(const long long n) { return format("%lld", n); }
+    size_t print(const unsigned long long n) { return format("%llu", n); }
+    size_t print(const double n) { return format("%.2f", n); }
+    size_t println() { return write("\r\n"); }
+private:
+    template <typename T>
+    size_t format(const char *spec, const T value) {
+        char text[32];
+        const int n = snprintf(text, sizeof(text), spec, value);
+        return n > 0 ? write(reinterpret_cast<const uint8_t *>(text), static_cast<size_t>(n)) : 0;
+    }
+};
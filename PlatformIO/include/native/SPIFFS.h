@@ -0,0 +1,19 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Native (simulator) stand-in for <SPIFFS.h>. The web pages aren't served in the simulator, so mounting always
+ *  succeeds and there are no files.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+namespace fs {
+    class FS {
+    public:
+        bool begin(bool = false) { return true; }
+    };
+} // namespace fs
+inline fs::FS SPIFFS;
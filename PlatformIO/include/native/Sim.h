@@ -0,0 +1,54 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Simulated board behind the native HAL (see 'Hal.h'). Time is virtual: nothing happens until the caller advances the
+ *  clock, at which point every timer that falls due fires in deadline order, on the calling thread. A run therefore
+ *  takes as long as the code under test takes to execute, not as long as the simulated time span, and is exactly
+ *  repeatable.
+ *      >> Periodic timers keep their schedule the way esp_timer does (next deadline = last deadline + period), so a
+ *         late callback doesn't shift the ones after it. setTimerJitter() delays each callback by a random amount on
+ *         top of its deadline to model dispatch latency on the board.
+ *      >> Every ADC pin reads a synthetic finger-flex signal by default (fingerFlex()); setSignal() replaces it.
+ *         setAdcConversionTime() charges each read against the clock, like a one-shot conversion would.
+ *      >> PWM writes go to a channel and are recorded per pin attached to it, so a test can check the last duty (and the
+ *         pulse width it gives at the channel's frequency and resolution) and count how often it changed.
+ *      >> adcMilliVolts() is an ideal linear ADC over 0 – ADC_FULL_SCALE mV (no eFuse data). Settings live in memory
+ *         and, like NVS, survive reset(); eraseSettings() is the simulated flash erase.
+ *      >> tasks() reports the simulator's one thread as a single task, "sim", busy for the whole virtual clock.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+#include <cstdint>
+#include <functional>
+
+namespace sim {
+    using Signal = std::function<uint16_t(uint64_t us)>;        // ADC reading (12-bit) at a point in simulated time
+
+    // ------ Clock ------
+    uint64_t now();                                             // Simulated time since reset (µs)
+    void advance(uint64_t us);                                  // Run the clock forward, firing due timers in order
+    void reset();                                               // Clock back to 0, timers disarmed, default signals
+
+    // ------ ADC ------
+    void setSignal(uint8_t pin, Signal signal);                 // Replace a pin's signal (nullptr restores the default)
+    uint16_t fingerFlex(uint8_t finger, uint64_t us);           // Default signal: repeated grasps, finger-dependent phase
+    void setAdcConversionTime(uint32_t us);                     // Clock cost of one read (default 0)
+    uint64_t adcReads();                                        // Reads since reset
+    constexpr uint32_t ADC_FULL_SCALE = 3100;                   // mV at a reading of 4095 (11 dB attenuation)
+
+    // ------ Settings ------
+    void eraseSettings();                                       // Drop every saved setting
+
+    // ------ PWM ------
+    uint32_t pwmDuty(uint8_t pin);                              // Last duty written to the pin (0 if never written)
+    uint64_t pwmWrites(uint8_t pin);                            // Writes to the pin since reset
+    uint64_t pwmWrittenAt(uint8_t pin);                         // Simulated time of the last write to the pin (µs)
+    uint64_t pwmPulseNs(uint8_t pin);                           // Pulse width the last duty gives (ns, 0 if not attached)
+
+    // ------ Timers ------
+    void setTimerJitter(uint32_t maxUs, uint32_t seed = 1);     // Delay each callback by 0 – maxUs (default 0)
+    uint64_t timerCallbacks();                                  // Callbacks fired since reset
+} // namespace sim
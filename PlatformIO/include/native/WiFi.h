@@ -0,0 +1,19 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Native (simulator) stand-in for <WiFi.h>. There's no radio; the access point always comes up.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#pragma once
+
+enum wifi_mode_t { WIFI_MODE_NULL, WIFI_MODE_STA, WIFI_MODE_AP, WIFI_MODE_APSTA };
+
+class WiFiClass {
+public:
+    static bool mode(wifi_mode_t) { return true; }
+    bool softAP(const char *, const char * = nullptr) { return true; }
+};
+inline WiFiClass WiFi;
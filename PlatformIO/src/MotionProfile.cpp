@@ -0,0 +1,85 @@
+#include "MotionProfile.h"
+#include <cmath>
+
+MotionProfile::MotionProfile() :
+    phases_{},
+    from_(0),
+    distance_(0),
+    direction_(1),
+    peak_(0),
+    duration_(0)
+{}
+
+bool MotionProfile::plan(const float from, const float to, const Limits &limits, const Shape shape) {
+    from_ = from;
+    distance_ = std::fabs(to - from);
+    direction_ = to < from ? -1.0f : 1.0f;
+    peak_ = 0;
+    duration_ = 0;
+    for (auto &phase : phases_) phase = {0, 0, 0, 0, 0};
+    if (limits.velocity <= 0 || limits.acceleration <= 0 || (shape == S_CURVE && limits.jerk <= 0)) return false;
+    if (distance_ == 0) return true;
+
+    const float A = limits.acceleration;
+    const float J = limits.jerk;
+    const bool jerkLimited = shape == S_CURVE;
+    /* Jerk phase and whole acceleration phase lengths to reach velocity v from rest */
+    const auto accelTimes = [A, J, jerkLimited](const float v, float &tj, float &ta) {
+        if (!jerkLimited) {                                     // trapezoid: acceleration steps straight to A
+            tj = 0;
+            ta = v / A;
+        } else if (v * J <= A * A) {                            // A is never reached: jerk up, jerk down
+            tj = std::sqrt(v / J);
+            ta = 2 * tj;
+        } else {
+            tj = A / J;
+            ta = v / A + tj;
+        }
+    };
+    float v = limits.velocity;
+    float tj, ta;
+    accelTimes(v, tj, ta);
+    if (v * ta > distance_) {                                   // too short to cruise: lower the peak so v·ta = distance
+        if (!jerkLimited) {
+            v = std::sqrt(distance_ * A);
+        } else if (const float v1 = std::cbrt(distance_ * distance_ * J / 4); v1 * J <= A * A) {
+            v = v1;
+        } else {
+            v = A / 2 * (-A / J + std::sqrt(A * A / (J * J) + 4 * distance_ / A));
+        }
+        accelTimes(v, tj, ta);
+    }
+    const float tv = std::fmax(0.0f, (distance_ - v * ta) / v);
+    const float a = jerkLimited ? J * tj : A;                   // peak acceleration
+    const float j = jerkLimited ? J : 0;
+    const float tc = std::fmax(0.0f, ta - 2 * tj);              // constant-acceleration part
+    const float durations[PHASES] = {tj, tc, tj, tv, tj, tc, tj};
+    const float jerks[PHASES] = {j, 0, -j, 0, -j, 0, j};
+    const float accelerations[PHASES] = {0, a, a, 0, 0, -a, -a};
+    float p = 0, vel = 0;
+    float total = 0;
+    for (uint8_t i = 0; i < PHASES; i++) {
+        const float t = durations[i];
+        phases_[i] = {t, jerks[i], p, vel, accelerations[i]};
+        p += vel * t + accelerations[i] * t * t / 2 + jerks[i] * t * t * t / 6;
+        vel += accelerations[i] * t + jerks[i] * t * t / 2;
+        total += t;
+    }
+    peak_ = v;
+    duration_ = static_cast<uint64_t>(std::lround(total * 1e6f));
+    return true;
+}
+
+float MotionProfile::position(const uint64_t elapsedUs) const {
+    if (elapsedUs >= duration_) return from_ + direction_ * distance_;
+    float t = static_cast<float>(elapsedUs) * 1e-6f;
+    for (const Phase &phase : phases_) {
+        if (t > phase.duration) {
+            t -= phase.duration;
+            continue;
+        }
+        const float p = phase.position + phase.velocity * t + phase.acceleration * t * t / 2 + phase.jerk * t * t * t / 6;
+        return from_ + direction_ * std::fmin(p, distance_);
+    }
+    return from_ + direction_ * distance_;
+}
@@ -0,0 +1,65 @@
+#include "TaskMonitor.h"
+
+void TaskMonitor::loop() {
+    if (sampled_ && hal::micros() - lastSample_ < static_cast<uint64_t>(period_) * 1000) return;
+    sample();
+}
+
+/* ------ Sample every task and publish the loads ------
+ * Run times are matched to the previous sample by task number (names needn't be unique). Loads are worked out in 64
+ * bits: a one-minute window is 6·10^7 µs, times FULL_LOAD.
+ */
+void TaskMonitor::sample() {
+    hal::TaskInfo found[hal::MAX_TASKS];
+    uint32_t clock = 0;
+    const size_t count = hal::tasks(found, clock);
+    lastSample_ = hal::micros();
+    sampled_ = true;
+    if (count == 0) return;                                     // no trace facility, or more tasks than fit
+    const uint32_t window = clock - clock_;                     // run-time clock wraps like the counters do
+    Snapshot next{};
+    next.window = window;
+    uint32_t ids[hal::MAX_TASKS];
+    uint32_t runtimes[hal::MAX_TASKS];
+    for (size_t i = 0; i < count; i++) {
+        const hal::TaskInfo &info = found[i];
+        uint32_t before = 0;                                    // new task: everything it has run
+        for (size_t j = 0; j < known_; j++) {
+            if (ids_[j] == info.id) {
+                before = runtimes_[j];
+                break;
+            }
+        }
+        const uint64_t load = window == 0 ? 0 : static_cast<uint64_t>(info.runtime - before) * FULL_LOAD / window;
+        Task task{};
+        memcpy(task.name, info.name, sizeof(task.name));
+        task.name[sizeof(task.name) - 1] = '\0';
+        for (char &c : task.name) {
+            if (c != '\0' && (c == '"' || c == '\\' || static_cast<uint8_t>(c) < ' ')) c = '_'; // safe to quote as-is
+        }
+        task.load = static_cast<uint16_t>(load > UINT16_MAX ? UINT16_MAX : load);
+        task.stackFree = info.stackFree;
+        task.core = info.core;
+        task.priority = info.priority;
+        if (info.idle && info.core >= 0 && static_cast<size_t>(info.core) < hal::CORES) next.idle[info.core] = task.load;
+        size_t at = next.count++;                               // insertion sort, busiest first
+        while (at > 0 && next.tasks[at - 1].load < task.load) {
+            next.tasks[at] = next.tasks[at - 1];
+            at--;
+        }
+        next.tasks[at] = task;
+        ids[i] = info.id;
+        runtimes[i] = info.runtime;
+    }
+    memcpy(ids_, ids, count * sizeof(ids[0]));
+    memcpy(runtimes_, runtimes, count * sizeof(runtimes[0]));
+    known_ = count;
+    clock_ = clock;
+    std::lock_guard<std::mutex> guard(lock_);
+    latest_ = next;
+}
+
+TaskMonitor::Snapshot TaskMonitor::snapshot() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return latest_;
+}
@@ -18,15 +18,21 @@
  *  AsyncWebServer  \code server_ \endcode
  *  @see AsyncWebServer
  */
-WebSocketBridge::WebSocketBridge() : server_(80),
-                                     ws_{"/ws"},
+WebSocketBridge::WebSocketBridge() : ws_{"/ws"},
+                                     server_(80),
+                                     inBuffer(&inArena_),
+                                     outBuffer(&outArena_),
+                                     reply_(nullptr),
+                                     replyLength_(0),
+                                     assembling_{},
+                                     requester_(0),
+                                     batchCount_(0),
+                                     pendingServo_(-1),
+                                     maxSendRate_(DEFAULT_MAX_SEND_RATE),
+                                     lastSend_(0),
+                                     sendSkips_(0),
                                      servo_{D4},
-                                     sensors {
-                                         FlexSensor("FLEX_2"),
-                                         FlexSensor("FLEX_3"),
-                                         FlexSensor("FLEX_4"),
-                                         FlexSensor("FLEX_5")
-                                     }
+                                     servoAngle_(NO_ANGLE)
 {}
 
 /*
@@ -36,10 +42,16 @@ WebSocketBridge::WebSocketBridge() : server_(80),
 void WebSocketBridge::setup() {
     Serial.begin(115200);   // Start serial monitor for debugging
     delay(1000);    // Wait for the serial port
+    sr::begin();    // from here on, logging only queues lines for the writer task
     sr::debug << "Last reset reason: " << esp_reset_reason() << sr::endl; // debug the last reset reason
     if (!SPIFFS.begin(true)) throw std::runtime_error("Failed to mount SPIFFS"); // throw a runtime error if SPIFFS fails
     WiFiClass::mode(WIFI_MODE_AP); // set the wifi mode to access point
     WiFi.softAP("RemoteExoskeleton", "remoteExoskeleton"); // set the ssid/pass of access point
+    server_.on("/metrics", HTTP_GET, [this](AsyncWebServerRequest *request) { // latency histograms and counters
+        AsyncResponseStream *response = request->beginResponseStream("text/plain; version=0.0.4");
+        writeMetrics(*response);
+        request->send(response);
+    });
     server_.serveStatic("/", SPIFFS, "/").setDefaultFile("index.html"); // serve default index.html page
     server_.serveStatic("/script.js", SPIFFS, "/script.js"); // serve the javascript page
     server_.serveStatic("/style.css", SPIFFS, "/style.css"); // serve the styling page
@@ -58,32 +70,83 @@ void WebSocketBridge::setup() {
     servo_.addAngleNotify([this](int pos) -> void { // register servo angle listener
         this->emitServoAngle(pos); // call to servo angle emitter
     });
+    sensors_.setup(); // create the one sampling timer shared by all sensors
+    if (sensors_.setupFailed()) {
+        sr::error << "Failed to setup flex sensor sampling." << sr::endl; // notify user of sampling failing to setup
+    }
     int i = 17; // starting at pin A0, setup all sensors
-    for (auto &sensor : sensors) { // for every sensor in the array...
-        sensor.setup(); // setup the sensor
+    for (auto &sensor : sensors_) { // for every sensor in the array...
         sensor.setPin(i); // set the pin to the local 'i'
         sensor.setFinger(static_cast<FlexSensor::Finger>(i - 15)); // set the sensor's finger to be enumerated value from difference of pin and 15 (starting at 2)
-        if (sensor.setupFailed()) {
-            sr::out << "Failed to setup sensor " << i - 16 << " on pin " << i << sr::endl; // notify user of sensor failing to setup
-        }
-        sensor.setNotifier([this](uint16_t val, const char *name) -> void { // register instance-method of sensor readings
-            emitSensorReading(val, name);
-        });
+        i++;
+    }
+    sensors_.setFrameNotifier([this](const FlexSensorArray::Frame &frame) -> void { // register listener for whole frames
+        emitSensorFrame(frame);
+    });
+    servo_.setWake(&controlWake_); // both timers wake the control task when they leave it work
+    sensors_.setWake(&controlWake_);
+#ifdef ARDUINO
+    if (xTaskCreatePinnedToCore(controlTask, "control", CONTROL_STACK, this, CONTROL_PRIORITY, nullptr, CONTROL_CORE) != pdPASS
+        || xTaskCreatePinnedToCore(networkTask, "network", NETWORK_STACK, this, NETWORK_PRIORITY, nullptr, NETWORK_CORE) != pdPASS) {
+        throw std::runtime_error("Failed to start the control/network tasks");
     }
+#endif
 }
 
 void WebSocketBridge::loop() {
-    while (!received.empty()) {
-        auto request = received.front(); // process all queued requests
-        handleReceived(request.c_str()); // call to parser
-        received.pop(); // pop from queue
+#ifdef ARDUINO
+    vTaskDelete(nullptr); // everything runs in the control and network tasks
+#else
+    controlPass();
+    networkPass();
+    delay(1);
+#endif
+}
+#ifdef ARDUINO
+/* ------ Task entry points ------
+ * Each pass runs before the first wait, so anything signalled before the task attached its event is still handled.
+ */
+void WebSocketBridge::controlTask(void *arg) {
+    auto *self = static_cast<WebSocketBridge *>(arg);
+    self->controlWake_.attach();
+    for (;;) {
+        self->controlPass();
+        self->controlWake_.wait(hal::FOREVER);
     }
-    ws_.cleanupClients(); // clean up all clients
-    servo_.loop(); // allow servo to actuate if enabled
-    for (auto &sensor : sensors) {
-        sensor.loop(); // allow sensors to notify / sample
+}
+void WebSocketBridge::networkTask(void *arg) {
+    auto *self = static_cast<WebSocketBridge *>(arg);
+    self->networkWake_.attach();
+    for (;;) {
+        self->networkPass();
+        self->networkWake_.wait(self->networkTimeout());
     }
-    delay(1); // prevent explosions
+}
+#endif
+void WebSocketBridge::controlPass() {
+    {
+        DeviceLock lock(devices_);
+        {
+            metrics::Scope probe(latency_[metrics::SERVO_LOOP]);
+            servo_.loop(); // allow servo to actuate if enabled
+        }
+        {
+            metrics::Scope probe(latency_[metrics::FLEX_LOOP]);
+            sensors_.loop(); // drain every frame the sampling timer queued
+        }
+    }
+    if (!frames_.empty() || servoAngle_.load(std::memory_order_acquire) != NO_ANGLE) networkWake_.signal(); // telemetry to send
+}
+void WebSocketBridge::networkPass() {
+    while (Requests::Slot *request = requests_.next()) { // process all committed requests
+        handleReceived(request->client, request->data, request->length); // call to parser
+        requests_.release(request); // hand the slot back to the AsyncTCP task
+    }
+    sendSnapshots(); // initial values for clients that just connected
+    ws_.cleanupClients(); // clean up all clients
+    drainTelemetry(); // frames and the servo angle the control task queued
+    flushTelemetry(); // one message per client for everything gathered above
+    tasks_.loop(); // per-task CPU load, once per sample period
 }
 /*
  * Private helper to send a client an invalid request from the last received
@@ -97,7 +160,7 @@ void WebSocketBridge::sendInvalidRequest(AsyncWebSocketClient *client) {
     const size_t n = serializeJson(outBuffer, buf); // grab size of serialized buffer
     client->text(buf, n); // send buffer to client
 
-    sr::out << "Sent invalid request: " <<
+    sr::warn << "Sent invalid request: " <<
         F(outBuffer["details"].as<const char *>() != nullptr ? outBuffer["details"].as<const char *>() : "null")
     << sr::endl; // print output statement
 }
@@ -147,116 +210,187 @@ void WebSocketBridge::sendSetResponse(AsyncWebSocketClient *client, const Status
     sr::debug << "Sent set response: \n >> " << buf << sr::endl; // notify user
 }
 
-/* ------ Method for sending a response to a get request ------
+/* ------ Method for composing a response to a get request ------
  *  const char* device - Device string
  *  const char* attr - Device's attribute string
  *  const T& val - Attribute's value (any type compatible w/ ArduinoJson)
+ *  Runs under devices_, so it only serializes into replyText_; sendReply() sends it after the lock is released.
  */
 template <typename T>
-void WebSocketBridge::sendGetResponse(const char *device, const char *attr, const T &val) {
+void WebSocketBridge::composeGetResponse(const char *device, const char *attr, const T &val) {
     outBuffer.clear(); // clear output
     outBuffer["dev"] = device; // set device, attr, val fields
     outBuffer["attr"] = attr;
     outBuffer["val"] = val;
-    char buf[200]; // allocate fixed char array buffer
-    const size_t n = serializeJson(outBuffer, buf); // grab size and serialize, sending to client
-    sr::debug << "Sent to client: " << buf << sr::endl; // print debug
-    ws_.textAll(buf, n);
-    sr::debug << "Sent get response: " << val << sr::endl; // print debug
-}
-/* ------ Callback for servo angle notifier ------
- *  This method sends all the clients connected the angle reading of the servo.
+    composeReply(replyText_, serializeJson(outBuffer, replyText_)); // grab size and serialize
+}
+/* ------ Method for composing a failed get request's response ------
+ *  For getters whose message couldn't be built (e.g. it outgrew its buffer), so the client isn't left waiting.
+ */
+void WebSocketBridge::composeErrorResponse(const char *device, const char *attr) {
+    outBuffer.clear();
+    outBuffer["dev"] = device;
+    outBuffer["req"] = "GET";
+    outBuffer["attr"] = attr;
+    outBuffer["stat"] = "ERROR";
+    composeReply(replyText_, serializeJson(outBuffer, replyText_));
+}
+void WebSocketBridge::composeReply(const char *text, const size_t length) {
+    reply_ = text;
+    replyLength_ = length;
+}
+void WebSocketBridge::sendReply(AsyncWebSocketClient *client) {
+    if (reply_ == nullptr) return;
+    sr::debug << "Sent to client: " << reply_ << sr::endl; // print debug
+    client->text(reply_, replyLength_);
+}
+/* ------ Callback for servo angle notifier (control task) ------
+ *  Overwrites the queued angle; only the latest angle is streamed.
  */
 void WebSocketBridge::emitServoAngle(int angle) {
-    char buf[200]; // allocate fixed-size char array
-    outBuffer.clear();  // clear output buffer
-    outBuffer["dev"] = "SERVO"; // device name is SERVO
-    outBuffer["attr"] = "POSITION"; // attribute is position reading
-    outBuffer["val"] = angle; // value is new reading
-    const size_t n = serializeJson(outBuffer, buf); // serialize, grabbing size of doc
-    ws_.textAll(buf, n); // notify all clients
+    servoAngle_.store(angle, std::memory_order_release);
 }
 
-/* ------ Callback method emitting a sensor reading to the client ------
- * The JSON message is as follows:
- * {
- *      dev: "[SERVO or FLEX_2/FLEX_3/FLEX_4/FLEX_5]",
- *      attr: "READ",
- *      val: [reading as uint16_t]
- * }
+/* ------ Callback for a frame of sensor readings (control task) ------
+ *  Runs under devices_ (inside sensors_.loop()), so control_ and the servo are used as they are. The setpoint stays
+ *  between the servo's start and stop angles.
+ *  Never blocks: if the network task has fallen FRAME_QUEUE_LENGTH frames behind, the frame is dropped and counted.
  */
-void WebSocketBridge::emitSensorReading(uint16_t val, const char *name) {
-    char buff[200];
-    outBuffer.clear();
-    outBuffer["dev"] = name;
-    outBuffer["attr"] = "READ";
-    outBuffer["val"] = val;
-    size_t n = serializeJson(outBuffer, buff);
-    sr::out << "Sensor reading: " << val << sr::endl;
-    ws_.textAll(buff, n);
-}
-/* ------ Method for parsing a FlexAttr from the inBuffer ------
- *  This method does c-style string operations on the received
- *  attr field of the inBuffer, retrieving the enumerated
- *  field.
- *
- *  I've mapped enumerations to string operations to enable switch statements,
- *  much faster on an embedded system vs. if-else chains on c-string operations.
- *
- */
-WebSocketBridge::FlexAttr WebSocketBridge::parseFlexAttr() {
-    if (inBuffer["attr"].isNull()) return FlexAttr::INVALID_FLEX_ATTR; // invalid if nullptr
-    const auto retrieved = inBuffer["attr"].as<const char *>(); // cast to c-style string (char array)
-    if (strcmp(retrieved, "SAMPLE_RATE") == 0) { // string comparison yields 0 difference
-        return FlexAttr::SampleRate; // sampling rate attribute
-    }
-    if (strcmp(retrieved, "START") == 0) { // string comp. yields 0 diff.
-        return FlexAttr::Start; // start attr
+void WebSocketBridge::emitSensorFrame(const FlexSensorArray::Frame &frame) {
+    if (control_.getMode() != AssistController::OFF) {
+        const ServoController::MilliDegrees start = servo_.getStartAngle() * ServoController::MILLI;
+        const ServoController::MilliDegrees stop = servo_.getStopAngle() * ServoController::MILLI;
+        const AssistController::Limits limits{start < stop ? start : stop, start < stop ? stop : start,
+                                              servo_.getSetpoint(), servo_.getMaxVelocity(),
+                                              sensors_.getSamplingInterval() * sensors_.getDecimation()};
+        if (ServoController::MilliDegrees setpoint; control_.update(frame, limits, setpoint)) servo_.track(setpoint);
     }
-    if (strcmp(retrieved, "STOP") == 0) { // 0 diff.
-        return FlexAttr::Stop; // stop
-    }
-    return FlexAttr::INVALID_FLEX_ATTR; // invalid otherwise
+    frames_.push(frame);
 }
-/* ------ Method for parsing flex sensor attributes ------
- * The only attribute for instances of flex sensors are the pins.
+
+/* ------ Move what the control task queued into the pending batch (network task) ------
+ *  A full batch is sent on the spot, ignoring the rate cap.
  */
-WebSocketBridge::FlexNAttr WebSocketBridge::parseFlexNAttr() {
-    if (inBuffer["attr"].isNull()) return FlexNAttr::INVALID_FLEX_N_ATTR; // nullptr == invalid
-    if (strcmp(inBuffer["attr"].as<const char *>(), "PIN") == 0) { // 0 difference in received vs PIN str
-        return FlexNAttr::Pin; // pin attribute
-    }
-    return FlexNAttr::INVALID_FLEX_N_ATTR; // invalid otherwise
-}
-/* ------ Method for parsing device field ------
- * Valid devices:
- *  "SERVO" <-> Device::Servo,
- *  "FLEX_n" <-> Device::Flex_n instance-based attributes
- *  "FLEX" <-> Device::Flex (static attributes—that is, attributes of the class, not actual objects themselves).
+void WebSocketBridge::drainTelemetry() {
+    if (const int angle = servoAngle_.exchange(NO_ANGLE, std::memory_order_acq_rel); angle != NO_ANGLE) pendingServo_ = angle;
+    FlexSensorArray::Frame frame;
+    while (frames_.pop(frame)) {
+        if (batchCount_ == BATCH_CAPACITY) flushTelemetry();
+        batch_[batchCount_++] = frame;
+    }
+}
+
+/* ------ How long the network task may sleep ------
+ *  Until the rate cap lets a pending batch go, or CLEANUP_PERIOD (or the task sample period, if shorter) if nothing
+ *  is pending. Rounded up to whole ms, so it never wakes just short of the batch being due.
  */
-WebSocketBridge::Device WebSocketBridge::parseDevice() {
-    const char *dev = inBuffer["dev"] | "INVALID";
+uint32_t WebSocketBridge::networkTimeout() const {
+    const uint32_t idle = tasks_.getPeriod() < CLEANUP_PERIOD ? tasks_.getPeriod() : CLEANUP_PERIOD;
+    if (batchCount_ == 0 && pendingServo_ < 0) return idle;
+    const uint64_t due = lastSend_ + 1000000ULL / maxSendRate_;
+    const uint64_t now = hal::micros();
+    if (now >= due) return 0;
+    const uint64_t ms = (due - now + 999) / 1000;
+    return ms < idle ? static_cast<uint32_t>(ms) : idle;
+}
 
-    if (strcmp(dev, "INVALID") == 0) {
-        return Device::INVALID_DEV;
-    }
-    if (strncmp(dev, "FLEX", 4) == 0) { // null terminator validating length since using strncmp vs strcmp
-        if (dev[4] == '\0') { // null terminator found where underscore is, so it's a static flex-sensor attribute
-            return Device::Flex;
+/* ------ Method sending the pending batch to every client ------
+ *  Binary clients get a packed BATCH message (see 'StreamProtocol.h'); JSON clients get:
+ *  {
+ *      dev: "BATCH",
+ *      flex: [ { seq: [frame no.], ts: [µs], mask: [sampled channels], val: [FLEX_2, FLEX_3, FLEX_4, FLEX_5],
+ *                ang: [angles (0.01º), null if uncalibrated] }, ... ],
+ *      servo: [angle, only if it changed]
+ *  }
+ *  Each payload is encoded at most once no matter how many clients share the format.
+ */
+void WebSocketBridge::flushTelemetry() {
+    if (batchCount_ == 0 && pendingServo_ < 0) return; // nothing gathered
+    const uint64_t now = hal::micros();
+    if (batchCount_ < BATCH_CAPACITY && now - lastSend_ < 1000000ULL / maxSendRate_) return; // keep gathering
+    lastSend_ = now;
+    constexpr uint8_t NOT_ENCODED = 0xFF;
+    uint8_t binaryFor = NOT_ENCODED; // subscriptions txBinary_ currently holds an encoding for
+    uint8_t textFor = NOT_ENCODED;   // likewise for txText_
+    size_t binaryLen = 0;
+    size_t textLen = 0;
+    for (auto &session : sessions_) {
+        const uint32_t id = session.id.load();
+        if (id == 0) continue;
+        const uint8_t wants = session.subscriptions.load() & (stream::FLEX | stream::SERVO);
+        const size_t count = wants & stream::FLEX ? batchCount_ : 0;
+        const int servo = wants & stream::SERVO ? pendingServo_ : -1;
+        if (count == 0 && servo < 0) continue; // nothing this client subscribed to
+        AsyncWebSocketClient *c = ws_.client(id);
+        if (c == nullptr) continue;
+        if (c->queueLen() >= MAX_CLIENT_QUEUE) { // client can't keep up; don't pile more onto its queue
+            sendSkips_++;
+            continue;
         }
-        switch (dev[5]) {   // switch statement on last char of received inBuffer["dev"] field
-            case '2': return Device::Flex_2; // char[5] = 'n' <-> "FLEX_n" where 2 <= n && n <= 5
-            case '3': return Device::Flex_3;
-            case '4': return Device::Flex_4;
-            case '5': return Device::Flex_5;
-            default: return Device::INVALID_DEV; // otherwise invalid
+        if (session.format.load() == stream::Format::BINARY) {
+            if (binaryFor != wants) {
+                metrics::Scope probe(latency_[metrics::ENCODE]);
+                binaryLen = stream::encodeBatch(batch_, count, servo, txBinary_);
+                binaryFor = wants;
+            }
+            metrics::Scope probe(latency_[metrics::SEND]);
+            c->binary(txBinary_, binaryLen);
+        } else {
+            if (textFor != wants) {
+                metrics::Scope probe(latency_[metrics::ENCODE]);
+                textLen = encodeJsonBatch(count, servo);
+                textFor = wants;
+            }
+            metrics::Scope probe(latency_[metrics::SEND]);
+            if (textLen > 0) c->text(txText_, textLen);
         }
     }
-    if (strcmp(dev, "SERVO") == 0) { // servo device
-        return Device::Servo;
+    batchCount_ = 0;
+    pendingServo_ = -1;
+}
+
+/* ------ JSON batch, written directly ------
+ *  The layout never changes, so it's written field by field with JsonWriter instead of going through outBuffer.
+ */
+size_t WebSocketBridge::encodeJsonBatch(const size_t count, const int servo) {
+    JsonWriter out(txText_, sizeof(txText_));
+    out.raw(R"({"dev":"BATCH","flex":[)");
+    for (size_t i = 0; i < count; i++) {
+        const FlexSensorArray::Frame &frame = batch_[i];
+        if (i > 0) out.raw(',');
+        out.raw(R"({"seq":)").number(frame.sequence)
+           .raw(R"(,"ts":)").number(frame.timestamp)
+           .raw(R"(,"mask":)").number(frame.mask)
+           .raw(R"(,"val":[)");
+        for (size_t j = 0; j < FlexSensorArray::SIZE; j++) {
+            if (j > 0) out.raw(',');
+            out.number(frame.readings[j]);
+        }
+        out.raw(R"(],"ang":[)");
+        for (size_t j = 0; j < FlexSensorArray::SIZE; j++) {
+            if (j > 0) out.raw(',');
+            if (frame.angles[j] == FlexCalibration::NO_ANGLE) out.raw("null");
+            else out.number(static_cast<int32_t>(frame.angles[j]));
+        }
+        out.raw("]}");
     }
-    return Device::INVALID_DEV; // invalid otherwise
+    out.raw(']');
+    if (servo >= 0) out.raw(R"(,"servo":)").number(static_cast<int32_t>(servo));
+    out.raw('}');
+    if (out.overflowed()) sr::error << "JSON batch of " << count << " frames doesn't fit txText_." << sr::endl;
+    return out.finish(); // 0 if it didn't fit; a truncated batch is never sent
+}
+
+#ifndef ARDUINO
+/* ------ JSON batch access for the native benchmarks (see 'src/native/JsonBench.cpp') ------ */
+size_t WebSocketBridge::jsonBatch(const FlexSensorArray::Frame *frames, size_t count, const int servo, const char *&text) {
+    count = count < BATCH_CAPACITY ? count : BATCH_CAPACITY;
+    for (size_t i = 0; i < count; i++) batch_[i] = frames[i];
+    text = txText_;
+    return encodeJsonBatch(count, servo);
 }
+#endif
+
 /* ------ Method to parse the request field of the inBuffer ------
  *
  */
@@ -273,303 +407,728 @@ WebSocketBridge::Method WebSocketBridge::parseMethod() {
     }
     return Method::INVALID_METHOD; // invalid otherwise
 }
-/* ------ Method to parse servo attributes ------
- * This method uses a search-tree pattern, an efficient computational search protocol
+/* ------ Session table ------
+ * Opened on connect and closed on disconnect (AsyncTCP task), read while streaming and replying (loop).
  */
-WebSocketBridge::ServoAttr WebSocketBridge::parseServoAttr() {
-    const char *attr = inBuffer["attr"];
-    if (attr == nullptr) return ServoAttr::INVALID_SERVO_ATTR;
-    // what letter does the command start with?
-    switch (attr[0]) {
-        case 'A': { // if A, try ACTUATE or ANGLE_STEP, invalid otherwise
-            if (strcmp(attr, "ACTUATE") == 0) return ServoAttr::Actuate;
-            if (strcmp(attr, "ANGLE_STEP") == 0) return ServoAttr::AngleStep;
-            return ServoAttr::INVALID_SERVO_ATTR;
+void WebSocketBridge::addClient(const uint32_t id) {
+    for (auto &session : sessions_) {
+        uint32_t free = 0;
+        if (session.id.compare_exchange_strong(free, id)) { // format/subscriptions were reset on close
+            session.needsSnapshot.store(true);
+            return;
         }
-            // try M
-        case 'M': {
-            switch (attr[3]) { // what about the fourth character? either an '_' or 'I'
-                case '_': {
-                    if (strcmp(attr, "MAX_PWM") == 0) {
-                        return ServoAttr::MaxPWM;
-                    }
-                    if (strcmp(attr, "MIN_PWM") == 0) {
-                        return ServoAttr::MinPWM;
-                    }
-                    if (strcmp(attr, "MAX_ANGLE") == 0) {
-                        return ServoAttr::MaxAngle;
-                    }
-                    return ServoAttr::INVALID_SERVO_ATTR;
-                }
-                default: { // try entire string comparison
-                    if (strcmp(attr, "MOTION") == 0) {
-                        return ServoAttr::Motion;
-                    }
-                    return ServoAttr::INVALID_SERVO_ATTR; // invalid otherwise
-                }
-            }
+    }
+    sr::warn << "No free session for client " << id << ". It won't receive readings." << sr::endl;
+}
+void WebSocketBridge::removeClient(const uint32_t id) {
+    if (Session *session = findClient(id); session != nullptr) {
+        session->format.store(stream::Format::JSON); // next client in this session starts on the defaults
+        session->subscriptions.store(stream::ALL);
+        session->needsSnapshot.store(false);
+        session->id.store(0);
+    }
+}
+WebSocketBridge::Session *WebSocketBridge::findClient(const uint32_t id) {
+    for (auto &session : sessions_) {
+        if (session.id.load() == id) return &session;
+    }
+    return nullptr;
+}
+void WebSocketBridge::sendSnapshots() {
+    for (auto &session : sessions_) {
+        if (!session.needsSnapshot.exchange(false)) continue;
+        if (AsyncWebSocketClient *client = ws_.client(session.id.load()); client != nullptr) handleConnect(client);
+    }
+}
+/* ------ Echo a change to the other dashboards ------
+ * STREAM attributes are per-connection settings (or counters), so they aren't echoed. The others read the same for
+ * every client, so the reply is composed once and sent to each subscriber after devices_ is released.
+ */
+void WebSocketBridge::broadcastChange(const Command &command) {
+    if (command.get == nullptr || strcmp(command.dev, "STREAM") == 0) return;
+    reply_ = nullptr;
+    {
+        DeviceLock lock(devices_);
+        command.get(*this, command, requester_);
+    }
+    for (auto &session : sessions_) {
+        const uint32_t id = session.id.load();
+        if (id == 0 || id == requester_ || !(session.subscriptions.load() & stream::CONFIG)) continue;
+        if (AsyncWebSocketClient *client = ws_.client(id); client != nullptr) sendReply(client);
+    }
+}
+/* ------ Request assembly ------
+ * AsyncWebSocket delivers a message as one or more frames (info->num counts them, info->final marks the last),
+ * and each frame as one or more chunks (info->index is the chunk's offset in the frame, info->len the frame's
+ * length). The message is complete at the last chunk of the final frame.
+ */
+void WebSocketBridge::onData(AsyncWebSocketClient *client, const AwsFrameInfo *info, const uint8_t *data, const size_t len) {
+    if (info->message_opcode != WS_TEXT) return; // commands are JSON text
+    const uint32_t id = client->id();
+    Assembly *assembly = nullptr;
+    for (auto &a : assembling_) { // the sender's in-flight request, or a free entry
+        if (a.client == id) { assembly = &a; break; }
+        if (assembly == nullptr && a.client == 0) assembly = &a;
+    }
+    if (assembly == nullptr) return; // more senders than clients; can't happen with MAX_CLIENTS entries
+    if (info->num == 0 && info->index == 0) { // first chunk of a new message
+        if (assembly->client == id && assembly->slot != nullptr) requests_.abandon(assembly->slot); // previous one never finished
+        assembly->client = id;
+        assembly->slot = requests_.acquire(); // nullptr if the pool is exhausted (counted as a drop)
+    } else if (assembly->client != id) {
+        return; // continuation of a message whose start we never saw
+    }
+    if (Requests::Slot *slot = assembly->slot; slot != nullptr) {
+        if (slot->length + len > Requests::CAPACITY) { // too long for a slot; drop the rest of it
+            requests_.countOversize();
+            requests_.abandon(slot);
+            assembly->slot = nullptr;
+        } else {
+            memcpy(slot->data + slot->length, data, len);
+            slot->length += len;
+        }
+    }
+    if (info->final && info->index + len == info->len) { // last chunk of the final frame
+        if (assembly->slot != nullptr) {
+            assembly->slot->client = id;
+            requests_.commit(assembly->slot);
+            networkWake_.signal();
         }
-            //starts w/ 'P'
-        case 'P':
-            // try position and pin
-            if (strcmp(attr, "PIN") == 0) return ServoAttr::Pin;
-            if (strcmp(attr, "POSITION") == 0) return ServoAttr::Position;
-            return ServoAttr::INVALID_SERVO_ATTR; // invalid otherwise
-        // try S
-        case 'S':
-            if (strcmp(attr, "START_ANGLE") == 0) return ServoAttr::StartAngle;
-            if (strcmp(attr, "STOP_ANGLE") == 0) return ServoAttr::StopAngle;
-            return ServoAttr::INVALID_SERVO_ATTR; // invalid
-        case 'T':
-            if (strcmp(attr, "TIME_DELAY") == 0) return ServoAttr::TimeDelayUS;
-            return ServoAttr::INVALID_SERVO_ATTR;
-        default:
-            return ServoAttr::INVALID_SERVO_ATTR; // invalid otherwise
+        assembly->client = 0;
+        assembly->slot = nullptr;
+    }
+}
+void WebSocketBridge::dropAssembly(const uint32_t id) {
+    for (auto &a : assembling_) {
+        if (a.client != id) continue;
+        if (a.slot != nullptr) requests_.abandon(a.slot);
+        a.client = 0;
+        a.slot = nullptr;
     }
 }
-
 /*
- * Callback for websocket events. unused server and arg parameters.
+ * Callback for websocket events. The server is always ws_, so its parameter is unused.
  */
-void WebSocketBridge::onWsEvent(AsyncWebSocket *server, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
+void WebSocketBridge::onWsEvent(AsyncWebSocket *, AsyncWebSocketClient *client, AwsEventType type, void *arg, uint8_t *data, size_t len) {
     switch (type) {
         case WS_EVT_CONNECT: {
-            handleConnect(client);
+            addClient(client->id()); // the network task sends its snapshot
+            networkWake_.signal();
         } break;
         case WS_EVT_DISCONNECT: {
+            dropAssembly(client->id());
+            removeClient(client->id());
             if (ws_.count() == 0) {
                 sr::out << "Client disconnected." << sr::endl;
-                for (auto &sensor : sensors) {
-                    sensor.setActive(false);
-                }
+                DeviceLock lock(devices_);
+                sensors_.setActive(false);
                 servo_.disableMotion();
             }
         } break;
         case WS_EVT_DATA: {
-            std::string msg(reinterpret_cast<const char *>(data), len);
-            sr::out << msg.c_str() << sr::endl;
-            received.push(msg);
+            onData(client, static_cast<AwsFrameInfo *>(arg), data, len);
         } break;
         case WS_EVT_PONG:
             ws_.pingAll();
         default: break;
     }
 }
-// initial config of servo/flex sensors
+// initial config of servo/flex sensors, to the new client only
 void WebSocketBridge::handleConnect(AsyncWebSocketClient *client) {
-    sr::out << "Client 1/1 connected. Sending current information." << sr::endl;
-    sendGetResponse( "SERVO", "ANGLE_STEP", servo_.getAngleStep());
-    sendGetResponse( "SERVO", "MAX_PWM", servo_.getPwmMax());
-    sendGetResponse( "SERVO", "MAX_ANGLE", servo_.getMaxAngle());
-    sendGetResponse( "SERVO", "MIN_PWM", servo_.getPwmMin());
-    sendGetResponse("SERVO", "MOTION", ServoController::motionString(servo_.getMotion()));
-    sendGetResponse("SERVO", "PIN", servo_.getPin());
-    sendGetResponse("SERVO", "POSITION", servo_.getPosition());
-    sendGetResponse( "SERVO", "START_ANGLE", servo_.getStartAngle());
-    sendGetResponse( "SERVO", "STOP_ANGLE", servo_.getStopAngle());
-    sendGetResponse( "SERVO", "TIME_DELAY", servo_.getTimeDelay());
-    sendGetResponse( "FLEX", "SAMPLE_RATE", FlexSensor::getSamplingInterval());
-    sendGetResponse("FLEX_2", "PIN", sensors[0].getPin().value_or(false));
-    sendGetResponse("FLEX_3", "PIN", sensors[1].getPin().value_or(false));
-    sendGetResponse("FLEX_4", "PIN", sensors[2].getPin().value_or(false));
-    sendGetResponse("FLEX_5", "PIN", sensors[3].getPin().value_or(false));
+    sr::out << "Client " << client->id() << " connected (" << ws_.count() << "/" << MAX_CLIENTS << "). Sending current information." << sr::endl;
+    {
+        DeviceLock lock(devices_); // the snapshot reads every device; serializing and sending below run without it
+        outBuffer.clear();
+        outBuffer["dev"] = "CONFIG";
+        outBuffer["ver"] = CONFIG_VERSION;
+        JsonObject servo = outBuffer["val"]["SERVO"].to<JsonObject>();
+        servo["ANGLE_STEP"] = servo_.getAngleStep();
+        servo["MAX_PWM"] = servo_.getPwmMax();
+        servo["MAX_ANGLE"] = servo_.getMaxAngle();
+        servo["MIN_PWM"] = servo_.getPwmMin();
+        servo["MOTION"] = ServoController::motionString(servo_.getMotion());
+        servo["PROFILE"] = ServoController::profileString(servo_.getProfile());
+        servo["PLAYBACK"] = servo_.getPlayback() ? "ON" : "OFF";
+        servo["MAX_VELOCITY"] = servo_.getMaxVelocity();
+        servo["MAX_ACCEL"] = servo_.getMaxAccel();
+        servo["MAX_JERK"] = servo_.getMaxJerk();
+        servo["PIN"] = servo_.getPin();
+        servo["POSITION"] = servo_.getPosition();
+        servo["START_ANGLE"] = servo_.getStartAngle();
+        servo["STOP_ANGLE"] = servo_.getStopAngle();
+        servo["TIME_DELAY"] = servo_.getTimeDelay();
+        JsonObject flex = outBuffer["val"]["FLEX"].to<JsonObject>();
+        flex["SAMPLE_RATE"] = sensors_.getSamplingInterval();
+        flex["OVERSAMPLE"] = sensors_.getOversample();
+        flex["CUTOFF"] = sensors_.getCutoff();
+        flex["DECIMATE"] = sensors_.getDecimation();
+        for (auto &sensor : sensors_) {
+            JsonObject flexN = outBuffer["val"][sensor.getName()].to<JsonObject>();
+            if (const auto p = sensor.getPin(); p.has_value()) flexN["PIN"] = p.value();
+            else flexN["PIN"] = false; // disconnected
+            flexN["CAL_POINT"] = sensor.getCalibration().getPointCount();
+            flexN["CAL_SAVE"] = sensor.getCalibration().isBuilt();
+        }
+        JsonObject control = outBuffer["val"]["CONTROL"].to<JsonObject>();
+        control["MODE"] = AssistController::modeString(control_.getMode());
+        control["CHANNELS"] = control_.getChannels();
+        control["TARGET"] = control_.getTarget();
+        control["GAIN"] = control_.getGain();
+        control["OFFSET"] = control_.getOffset();
+        control["KP"] = control_.getKp();
+        control["KI"] = control_.getKi();
+        control["KD"] = control_.getKd();
+        control["DEADBAND"] = control_.getDeadband();
+    }
+    if (outBuffer.overflowed()) {
+        sr::error << "CONFIG snapshot doesn't fit the output arena." << sr::endl;
+        return;
+    }
+    if (const size_t length = measureJson(outBuffer); length >= sizeof(txText_)) { // never send a truncated snapshot
+        sr::error << "CONFIG snapshot of " << length << " bytes doesn't fit txText_." << sr::endl;
+        return;
+    }
+    client->text(txText_, serializeJson(outBuffer, txText_)); // one message instead of one per attribute
+}
+/* ------ Counters ------
+ * Everything /metrics and STATS report besides the histograms: { name, counts since boot?, reader }. Readers run on
+ * the AsyncTCP task (/metrics) or the network task (STATS), so they only read atomics or the SDK's heap counters.
+ */
+struct WebSocketBridge::Stats {
+    struct Counter {
+        const char *name;                               // STATS key; exo_<name> in Prometheus (+ _total if counted)
+        bool total;                                     // Counts up since boot (a Prometheus counter), else a gauge
+        uint32_t (*read)(WebSocketBridge &);
+    };
+    static constexpr Counter COUNTERS[] = {
+        {"servo_missed_ticks", true, [](WebSocketBridge &b) { return b.servo_.getMissedTicks(); }},
+        {"flex_overruns", true, [](WebSocketBridge &b) { return b.sensors_.getOverruns(); }},
+        {"flex_queue_high_water", false, [](WebSocketBridge &b) { return b.sensors_.getQueueHighWater(); }},
+        {"frame_drops", true, [](WebSocketBridge &b) { return b.frames_.overruns(); }},
+        {"frame_queue_depth", false, [](WebSocketBridge &b) { return static_cast<uint32_t>(b.frames_.size()); }},
+        {"frame_queue_high_water", false, [](WebSocketBridge &b) { return b.frames_.highWater(); }},
+        {"request_queue_depth", false, [](WebSocketBridge &b) { return static_cast<uint32_t>(b.requests_.pending()); }},
+        {"request_drops", true, [](WebSocketBridge &b) { return b.requests_.drops() + b.requests_.oversize(); }},
+        {"send_skips", true, [](WebSocketBridge &b) { return b.sendSkips_.load(); }},
+        {"log_drops", true, [](WebSocketBridge &) { return sr::dropped(); }},
+        {"heap_free_bytes", false, [](WebSocketBridge &) { return ESP.getFreeHeap(); }},
+        {"heap_min_free_bytes", false, [](WebSocketBridge &) { return ESP.getMinFreeHeap(); }},
+        {"heap_largest_block_bytes", false, [](WebSocketBridge &) { return ESP.getMaxAllocHeap(); }},
+        {"clients", false, [](WebSocketBridge &b) { return static_cast<uint32_t>(b.ws_.count()); }},
+    };
+};
 
+/* ------ GET /metrics (AsyncTCP task) ------
+ *  exo_latency_us{probe="..."} histograms, one line per counter, and each client's send queue.
+ */
+void WebSocketBridge::writeMetrics(Print &out) {
+    out.print("# TYPE exo_latency_us histogram\n");
+    for (size_t p = 0; p < metrics::PROBES; p++) {
+        metrics::writePrometheus(out, "exo_latency_us", metrics::PROBE_NAMES[p], latency_[p]);
+    }
+    for (const auto &counter : Stats::COUNTERS) {
+        const char *suffix = counter.total ? "_total" : "";
+        out.print("# TYPE exo_"); out.print(counter.name); out.print(suffix);
+        out.print(counter.total ? " counter\n" : " gauge\n");
+        out.print("exo_"); out.print(counter.name); out.print(suffix); out.print(' ');
+        out.print(counter.read(*this)); out.print('\n');
+    }
+    out.print("# TYPE exo_client_send_queue gauge\n");
+    for (auto &session : sessions_) {
+        const uint32_t id = session.id.load();
+        const AsyncWebSocketClient *c = id != 0 ? ws_.client(id) : nullptr;
+        if (c == nullptr) continue;
+        out.print("exo_client_send_queue{client=\""); out.print(id); out.print("\"} ");
+        out.print(static_cast<uint32_t>(c->queueLen())); out.print('\n');
+    }
+    const TaskMonitor::Snapshot sample = tasks_.snapshot();
+    const auto percent = [&out](const uint16_t load) { // 0.01 % as a decimal
+        out.print(static_cast<uint32_t>(load / 100)); out.print('.');
+        if (load % 100 < 10) out.print('0');
+        out.print(static_cast<uint32_t>(load % 100)); out.print('\n');
+    };
+    if (sample.window > 0) { // loads need the core's run-time stats
+        out.print("# TYPE exo_task_cpu_percent gauge\n");
+        for (size_t i = 0; i < sample.count; i++) {
+            const TaskMonitor::Task &task = sample.tasks[i];
+            out.print("exo_task_cpu_percent{task=\""); out.print(task.name); out.print("\",core=\"");
+            if (task.core == hal::NO_CORE) out.print("any");
+            else out.print(static_cast<int>(task.core));
+            out.print("\"} "); percent(task.load);
+        }
+        out.print("# TYPE exo_core_idle_percent gauge\n");
+        for (size_t core = 0; core < hal::CORES; core++) {
+            out.print("exo_core_idle_percent{core=\""); out.print(static_cast<uint32_t>(core)); out.print("\"} ");
+            percent(sample.idle[core]);
+        }
+    }
+    out.print("# TYPE exo_task_stack_free_bytes gauge\n");
+    for (size_t i = 0; i < sample.count; i++) {
+        out.print("exo_task_stack_free_bytes{task=\""); out.print(sample.tasks[i].name); out.print("\"} ");
+        out.print(sample.tasks[i].stackFree); out.print('\n');
+    }
 }
-// set related fields of the inBuffer JSON from received fields
-void WebSocketBridge::handleReceived(const char *request) {
-    inBuffer.clear();
-    DeserializationError error = deserializeJson(inBuffer, request);
-    if (error) {
-        sr::out << "Failed to parse request: " << error.c_str() << sr::endl;
-        return;
+
+/* ------ STATS message, written directly (network task) ------
+ *  {
+ *      dev: "STATS", attr: "ALL",
+ *      val: { bounds_us: [bucket upper bounds], latency: { [probe]: { count, sum_us, max_us, buckets: [...] }, ... },
+ *             counters: { [name]: value, ... }, clients: [ { id, queue }, ... ] }
+ *  }
+ *  buckets has one more entry than bounds_us: everything longer than the last bound.
+ */
+size_t WebSocketBridge::encodeStats() {
+    JsonWriter out(txText_, sizeof(txText_));
+    out.raw(R"({"dev":"STATS","attr":"ALL","val":{"bounds_us":[)");
+    for (size_t i = 0; i < metrics::BUCKETS - 1; i++) {
+        if (i > 0) out.raw(',');
+        out.number(metrics::BOUNDS[i]);
     }
-    auto dev = parseDevice(); // get device, request
-    auto req = parseMethod();
-    if (dev != Device::INVALID_DEV && req != Method::INVALID_METHOD) { // continue if not invalid
-        switch (dev) { // switch between devices
-            case Device::Servo: { // attempt servo attribute get/set
-                const auto attr = parseServoAttr();
-                if (req == Method::SET && !inBuffer["val"].isNull()) { // must be a setter
-                    switch (attr) {
-                        case ServoAttr::AngleStep:
-                            servo_.setAngleStep(inBuffer["val"].as<int>());
-                            break;
-                        case ServoAttr::TimeDelayUS:
-                            servo_.setTimeDelay(inBuffer["val"].as<int>());
-                            break;
-                        case ServoAttr::MinPWM:
-                            servo_.setMaxPWM(inBuffer["val"].as<int>());
-                            break;
-                        case ServoAttr::MaxPWM:
-                            servo_.setMinPWM(inBuffer["val"].as<int>());
-                            break;
-                        case ServoAttr::Position:
-                            servo_.setPosition(inBuffer["val"].as<int>());
-                            break;
-                        case ServoAttr::Pin:
-                            servo_.setPin(inBuffer["val"].as<uint8_t>());
-                            break;
-                        case ServoAttr::Actuate: {
-                            if (const auto enabled = inBuffer["val"].as<bool>(); enabled == true) {
-                                servo_.enableMotion();
-                            } else {
-                                servo_.disableMotion();
-                            }
-                        } break;
-                        case ServoAttr::StartAngle:
-                            servo_.setStartAngle(inBuffer["val"].as<int>());
-                            break;
-                        case ServoAttr::StopAngle:
-                            servo_.setStopAngle(inBuffer["val"].as<int>());
-                            break;
-                        case ServoAttr::Motion:
-                            servo_.setMotion(ServoController::fromString( inBuffer["val"].as<const char *>()));
-                            break;
-                        case ServoAttr::MaxAngle:
-                            servo_.setMaxAngle(inBuffer["val"].as<unsigned int>());
-                            break;
-                        default:
-                            sr::out << "Invalid servo attribute: " << inBuffer["val"].as<const char *>() << sr::endl;
-                            sendInvalidAttr(&ws_.getClients().front());
-                            break;
-                    }
-                }
-                else if (req == Method::GET) { // try a getter
-                    // redundant parsing, just send the associated attribute from the attribute.
-                    switch (attr) {
-                        case ServoAttr::AngleStep:
-                            sendGetResponse("SERVO", "ANGLE_STEP", servo_.getAngleStep());
-                            break;
-                        case ServoAttr::TimeDelayUS:
-                            sendGetResponse("SERVO", "TIME_DELAY", servo_.getTimeDelay());
-                            break;
-                        case ServoAttr::MinPWM:
-                            sendGetResponse("SERVO", "MIN_PWM", servo_.getPwmMin());
-                            break;
-                        case ServoAttr::MaxPWM:
-                            sendGetResponse( "SERVO", "MAX_PWM", servo_.getPwmMax());
-                            break;
-                        case ServoAttr::Position:
-                            sendGetResponse("SERVO", "POSITION", servo_.getPosition());
-                            break;
-                        case ServoAttr::Pin:
-                            sendGetResponse("SERVO", "PIN", servo_.getPin());
-                            break;
-                        case ServoAttr::Actuate:
-                            sendGetResponse( "SERVO", "ACTUATE", servo_.isActive());
-                            break;
-                        case ServoAttr::StartAngle:
-                            sendGetResponse( "SERVO", "START_ANGLE", servo_.getStartAngle());
-                            break;
-                        case ServoAttr::StopAngle:
-                            sendGetResponse( "SERVO", "STOP_ANGLE", servo_.getStopAngle());
-                            break;
-                        case ServoAttr::Motion:
-                            sendGetResponse( "SERVO", "MOTION", ServoController::motionString(servo_.getMotion()));
-                            break;
-                        case ServoAttr::MaxAngle:
-                            sendGetResponse("SERVO", "MAX_ANGLE", servo_.getMaxAngle());
-                            break;
-                        default:
-                            sendInvalidAttr(&ws_.getClients().front());
-                    }
-                }
-                else { // invalid method otherwise
-                    sendInvalidRequest(&ws_.getClients().front());
-                }
-            } break; // end Device::Servo case
-            case Device::Flex: {
-                if (auto attr = parseFlexAttr(); attr != FlexAttr::INVALID_FLEX_ATTR) {
-                    if (attr == FlexAttr::SampleRate) {
-                        if (req == Method::SET) {
-                            if (inBuffer["val"].isNull()) {
-                                sendInvalidAttr(&ws_.getClients().front());
-                            } else {
-                                bool wasActive = sensors[0].getActive();
-                                for (auto &sensor : sensors) {
-                                    sensor.setActive(false);
-                                }
-                                FlexSensor::setSamplingInterval(inBuffer["val"].as<unsigned int>());
-                                if (wasActive) {
-                                    for (auto &sensor : sensors) {
-                                        sensor.setActive(true);
-                                    }
-                                }
-                            }
-                        } else {
-                            sendGetResponse("FLEX", "SAMPLE_RATE", FlexSensor::getSamplingInterval());
-                        }
-                    } else if (attr == FlexAttr::Start) {
-                        for (auto &sensor : sensors) {
-                            sensor.setActive(true);
-                        }
-                        sendSetResponse(&ws_.getClients().front(), OK);
-                    } else {
-                        for (auto &sensor : sensors) {
-                            sensor.setActive(false);
-                        }
-                        sendSetResponse(&ws_.getClients().front(), OK);
-                    }
-                } else {
-                    sendInvalidAttr(&ws_.getClients().front());
+    out.raw(R"(],"latency":{)");
+    for (size_t p = 0; p < metrics::PROBES; p++) {
+        const metrics::Histogram &histogram = latency_[p];
+        if (p > 0) out.raw(',');
+        out.name(metrics::PROBE_NAMES[p])
+           .raw(R"(:{"count":)").number(histogram.count())
+           .raw(R"(,"sum_us":)").number(histogram.sum())
+           .raw(R"(,"max_us":)").number(histogram.max())
+           .raw(R"(,"buckets":[)");
+        for (size_t i = 0; i < metrics::BUCKETS; i++) {
+            if (i > 0) out.raw(',');
+            out.number(histogram.bucket(i));
+        }
+        out.raw("]}");
+    }
+    out.raw(R"(},"counters":{)");
+    bool first = true;
+    for (const auto &counter : Stats::COUNTERS) {
+        if (!first) out.raw(',');
+        first = false;
+        out.name(counter.name).raw(':').number(counter.read(*this));
+    }
+    out.raw(R"(},"clients":[)");
+    first = true;
+    for (auto &session : sessions_) {
+        const uint32_t id = session.id.load();
+        const AsyncWebSocketClient *c = id != 0 ? ws_.client(id) : nullptr;
+        if (c == nullptr) continue;
+        if (!first) out.raw(',');
+        first = false;
+        out.raw(R"({"id":)").number(id).raw(R"(,"queue":)").number(static_cast<uint32_t>(c->queueLen())).raw('}');
+    }
+    out.raw("]}}");
+    if (out.overflowed()) sr::error << "STATS message doesn't fit txText_." << sr::endl;
+    return out.finish();
+}
+
+/* ------ TASKS message, written directly (network task) ------
+ *  {
+ *      dev: "TASKS", attr: "ALL",
+ *      val: { period_ms, window_us: [run-time clock covered, 0 if loads are unavailable], idle: [core 0, core 1],
+ *             tasks: [ { name, core: [0/1, null if either], prio, load, stack: [least free bytes] }, ... ] }
+ *  }
+ *  Loads are hundredths of a percent of one core, busiest task first.
+ */
+size_t WebSocketBridge::encodeTasks() {
+    const TaskMonitor::Snapshot sample = tasks_.snapshot();
+    JsonWriter out(txText_, sizeof(txText_));
+    out.raw(R"({"dev":"TASKS","attr":"ALL","val":{"period_ms":)").number(tasks_.getPeriod())
+       .raw(R"(,"window_us":)").number(sample.window)
+       .raw(R"(,"idle":[)");
+    for (size_t core = 0; core < hal::CORES; core++) {
+        if (core > 0) out.raw(',');
+        out.number(sample.idle[core]);
+    }
+    out.raw(R"(],"tasks":[)");
+    for (size_t i = 0; i < sample.count; i++) {
+        const TaskMonitor::Task &task = sample.tasks[i];
+        if (i > 0) out.raw(',');
+        out.raw(R"({"name":)").name(task.name).raw(R"(,"core":)");
+        if (task.core == hal::NO_CORE) out.raw("null");
+        else out.number(static_cast<int32_t>(task.core));
+        out.raw(R"(,"prio":)").number(task.priority)
+           .raw(R"(,"load":)").number(task.load)
+           .raw(R"(,"stack":)").number(task.stackFree)
+           .raw('}');
+    }
+    out.raw("]}}");
+    if (out.overflowed()) sr::error << "TASKS message of " << sample.count << " tasks doesn't fit txText_." << sr::endl;
+    return out.finish();
+}
+
+/* ------ Command table ------
+ * One row per (dev, attr) pair: { dev, attr, coercion, min, max, getter, setter[, unlocked] }. A missing getter/setter
+ * makes the attribute write-/read-only. Setters report ERROR when the device refused or adjusted the value (read back after
+ * setting), so the web page re-requests the value actually in effect.
+ * The index is built by the compiler (see 'CommandTable.h'); the static_assert fails the build if it can't be.
+ */
+struct WebSocketBridge::Commands {
+    static Status applied(const long wanted, const long actual) { return wanted == actual ? OK : ERROR; }
+    template <size_t I> static void getFlexPin(WebSocketBridge &b, const Command &c, const uint32_t) {
+        if (const auto pin = b.sensors_[I].getPin(); pin.has_value()) b.composeGetResponse(c.dev, c.attr, pin.value());
+        else b.composeGetResponse(c.dev, c.attr, false); // disconnected
+    }
+    template <size_t I> static Status setFlexPin(WebSocketBridge &b, const Arg &a) {
+        return b.sensors_[I].setPin(a.detach ? std::nullopt : std::optional<uint16_t>(a.number)) ? OK : ERROR;
+    }
+    template <size_t I> static void getCalPoints(WebSocketBridge &b, const Command &c, const uint32_t) {
+        b.composeGetResponse(c.dev, c.attr, static_cast<uint32_t>(b.sensors_[I].getCalibration().getPointCount()));
+    }
+    template <size_t I> static Status captureCal(WebSocketBridge &b, const Arg &a) {
+        return b.sensors_[I].captureCalibration(static_cast<int16_t>(a.number * 100)) ? OK : ERROR;
+    }
+    template <size_t I> static void getCalSaved(WebSocketBridge &b, const Command &c, const uint32_t) {
+        b.composeGetResponse(c.dev, c.attr, b.sensors_[I].getCalibration().isBuilt());
+    }
+    template <size_t I> static Status saveCal(WebSocketBridge &b, const Arg &) {
+        return b.sensors_[I].saveCalibration() ? OK : ERROR;
+    }
+    template <size_t I> static Status clearCal(WebSocketBridge &b, const Arg &) {
+        b.sensors_[I].clearCalibration();
+        return OK;
+    }
+    static constexpr Command ROWS[] = {
+        // ------ SERVO: defaults are for a 270º servo w/ 270º rotation @ 500 – 2500 µs (see 'ServoController.h')
+        {"SERVO", "ANGLE_STEP", Coerce::Int, -360, 360,             // Angle increment (º) per timer tick.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.servo_.getAngleStep()); },
+            [](WebSocketBridge &b, const Arg &a) { b.servo_.setAngleStep(a.number); return applied(a.number, b.servo_.getAngleStep()); }},
+        {"SERVO", "TIME_DELAY", Coerce::Int, 0, LONG_MAX,           // Delay (µs) between angle increments.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.servo_.getTimeDelay()); },
+            [](WebSocketBridge &b, const Arg &a) { b.servo_.setTimeDelay(a.number); return applied(a.number, b.servo_.getTimeDelay()); }},
+        {"SERVO", "MIN_PWM", Coerce::Int, 0, 20000,                 // Minimum pulse width (µs), from the data sheet.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.servo_.getPwmMin()); },
+            [](WebSocketBridge &b, const Arg &a) { b.servo_.setMinPWM(a.number); return applied(a.number, b.servo_.getPwmMin()); }},
+        {"SERVO", "MAX_PWM", Coerce::Int, 0, 20000,                 // Maximum pulse width (µs), from the data sheet.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.servo_.getPwmMax()); },
+            [](WebSocketBridge &b, const Arg &a) { b.servo_.setMaxPWM(a.number); return applied(a.number, b.servo_.getPwmMax()); }},
+        {"SERVO", "POSITION", Coerce::Int, 0, 360,                  // Angular position (º).
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.servo_.getPosition()); },
+            [](WebSocketBridge &b, const Arg &a) { b.servo_.setPosition(a.number); return applied(a.number, b.servo_.getPosition()); }},
+        {"SERVO", "SETPOINT", Coerce::Int, 0, 360000,               // Angular position (0.001º), for sub-degree moves.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.servo_.getSetpoint()); },
+            [](WebSocketBridge &b, const Arg &a) { b.servo_.setSetpoint(a.number); return applied(a.number, b.servo_.getSetpoint()); }},
+        {"SERVO", "PIN", Coerce::Int, 0, 48,                        // GPIO the servo's signal wire is on.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.servo_.getPin()); },
+            [](WebSocketBridge &b, const Arg &a) { b.servo_.setPin(a.number); return applied(a.number, b.servo_.getPin()); }},
+        {"SERVO", "ACTUATE", Coerce::Bool, 0, 1,                    // Enable/disable controlled-speed motion.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.servo_.isActive()); },
+            [](WebSocketBridge &b, const Arg &a) {
+                if (a.number) b.servo_.enableMotion();
+                else b.servo_.disableMotion();
+                return OK;
+            }},
+        {"SERVO", "START_ANGLE", Coerce::Int, 0, 360,               // Angle (º) controlled motion starts from.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.servo_.getStartAngle()); },
+            [](WebSocketBridge &b, const Arg &a) { b.servo_.setStartAngle(a.number); return applied(a.number, b.servo_.getStartAngle()); }},
+        {"SERVO", "STOP_ANGLE", Coerce::Int, 0, 360,                // Angle (º) controlled motion stops at.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.servo_.getStopAngle()); },
+            [](WebSocketBridge &b, const Arg &a) { b.servo_.setStopAngle(a.number); return applied(a.number, b.servo_.getStopAngle()); }},
+        {"SERVO", "MOTION", Coerce::Text, 0, 0,                     // LOOP/SWEEP/ONE_SHOT (see 'ServoController.h').
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, ServoController::motionString(b.servo_.getMotion())); },
+            [](WebSocketBridge &b, const Arg &a) {
+                const auto motion = ServoController::fromString(a.text);
+                if (motion == ServoController::INVALID) return ERROR;
+                b.servo_.setMotion(motion);
+                return OK;
+            }},
+        {"SERVO", "MAX_ANGLE", Coerce::Int, 1, 360,                 // Servo's full range (º), used for the duty cycle.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.servo_.getMaxAngle()); },
+            [](WebSocketBridge &b, const Arg &a) { b.servo_.setMaxAngle(a.number); return applied(a.number, b.servo_.getMaxAngle()); }},
+        {"SERVO", "PROFILE", Coerce::Text, 0, 0,                    // STEP/TRAPEZOID/S_CURVE (see 'ServoController.h').
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, ServoController::profileString(b.servo_.getProfile())); },
+            [](WebSocketBridge &b, const Arg &a) {
+                const auto profile = ServoController::profileFromString(a.text);
+                if (profile == ServoController::INVALID_PROFILE) return ERROR;
+                b.servo_.setProfile(profile);
+                return OK;
+            }},
+        {"SERVO", "PLAYBACK", Coerce::Text, 0, 0,                   // ON/OFF: play TRAPEZOID/S_CURVE from the timer.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.servo_.getPlayback() ? "ON" : "OFF"); },
+            [](WebSocketBridge &b, const Arg &a) {
+                if (strcmp(a.text, "ON") != 0 && strcmp(a.text, "OFF") != 0) return ERROR;
+                b.servo_.setPlayback(strcmp(a.text, "ON") == 0);
+                return OK;
+            }},
+        {"SERVO", "MAX_VELOCITY", Coerce::Int, 1, 3600,             // Profile velocity limit (º/s).
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.servo_.getMaxVelocity()); },
+            [](WebSocketBridge &b, const Arg &a) { b.servo_.setMaxVelocity(a.number); return applied(a.number, b.servo_.getMaxVelocity()); }},
+        {"SERVO", "MAX_ACCEL", Coerce::Int, 1, 100000,              // Profile acceleration limit (º/s²).
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.servo_.getMaxAccel()); },
+            [](WebSocketBridge &b, const Arg &a) { b.servo_.setMaxAccel(a.number); return applied(a.number, b.servo_.getMaxAccel()); }},
+        {"SERVO", "MAX_JERK", Coerce::Int, 1, 1000000,              // S_CURVE jerk limit (º/s³).
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.servo_.getMaxJerk()); },
+            [](WebSocketBridge &b, const Arg &a) { b.servo_.setMaxJerk(a.number); return applied(a.number, b.servo_.getMaxJerk()); }},
+        // ------ FLEX: attributes shared by every flex sensor
+        {"FLEX", "SAMPLE_RATE", Coerce::Int, FlexSensorArray::MIN_SAMPLING_INTERVAL, LONG_MAX, // Sampling interval (µs).
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.sensors_.getSamplingInterval()); },
+            [](WebSocketBridge &b, const Arg &a) {
+                if (!b.sensors_.setSamplingInterval(a.number)) return ERROR;
+                b.control_.reset();                                 // the frame period changed
+                return OK;
+            }},
+        {"FLEX", "OVERSAMPLE", Coerce::Int, 1, FlexSensorArray::MAX_OVERSAMPLE, // Reads averaged per channel per scan (power of two).
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.sensors_.getOversample()); },
+            [](WebSocketBridge &b, const Arg &a) { return b.sensors_.setOversample(a.number) ? OK : ERROR; }},
+        {"FLEX", "CUTOFF", Coerce::Int, 0, LONG_MAX,                // Low-pass cutoff (mHz), 0 to bypass.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.sensors_.getCutoff()); },
+            [](WebSocketBridge &b, const Arg &a) { return b.sensors_.setCutoff(a.number) ? OK : ERROR; }},
+        {"FLEX", "DECIMATE", Coerce::Int, 1, FlexSensorArray::MAX_DECIMATION, // Scans averaged into each frame.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.sensors_.getDecimation()); },
+            [](WebSocketBridge &b, const Arg &a) {
+                if (!b.sensors_.setDecimation(a.number)) return ERROR;
+                b.control_.reset();                                 // the frame period changed
+                return OK;
+            }},
+        {"FLEX", "START", Coerce::None, 0, 0,                       // Start sampling (value ignored).
+            nullptr,
+            [](WebSocketBridge &b, const Arg &) { b.sensors_.setActive(true); return OK; }},
+        {"FLEX", "STOP", Coerce::None, 0, 0,                        // Stop sampling (value ignored).
+            nullptr,
+            [](WebSocketBridge &b, const Arg &) { b.sensors_.setActive(false); return OK; }},
+        {"FLEX", "OVERRUNS", Coerce::None, 0, 0,                    // Frames dropped because the control task fell behind.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.sensors_.getOverruns()); },
+            nullptr},
+        // ------ FLEX_n: the ADC pin each sensor is on (A0 – A7), or false if disconnected
+        {"FLEX_2", "PIN", Coerce::Pin, A0, A7, getFlexPin<0>, setFlexPin<0>},
+        {"FLEX_3", "PIN", Coerce::Pin, A0, A7, getFlexPin<1>, setFlexPin<1>},
+        {"FLEX_4", "PIN", Coerce::Pin, A0, A7, getFlexPin<2>, setFlexPin<2>},
+        {"FLEX_5", "PIN", Coerce::Pin, A0, A7, getFlexPin<3>, setFlexPin<3>},
+        // ------ FLEX_n calibration (see 'FlexCalibration.h'): capture the current reading at an angle (º), then save
+        {"FLEX_2", "CAL_POINT", Coerce::Int, 0, 180, getCalPoints<0>, captureCal<0>},  // GET: points captured
+        {"FLEX_3", "CAL_POINT", Coerce::Int, 0, 180, getCalPoints<1>, captureCal<1>},
+        {"FLEX_4", "CAL_POINT", Coerce::Int, 0, 180, getCalPoints<2>, captureCal<2>},
+        {"FLEX_5", "CAL_POINT", Coerce::Int, 0, 180, getCalPoints<3>, captureCal<3>},
+        {"FLEX_2", "CAL_SAVE", Coerce::None, 0, 0, getCalSaved<0>, saveCal<0>},        // GET: whether angles are sent
+        {"FLEX_3", "CAL_SAVE", Coerce::None, 0, 0, getCalSaved<1>, saveCal<1>},
+        {"FLEX_4", "CAL_SAVE", Coerce::None, 0, 0, getCalSaved<2>, saveCal<2>},
+        {"FLEX_5", "CAL_SAVE", Coerce::None, 0, 0, getCalSaved<3>, saveCal<3>},
+        {"FLEX_2", "CAL_CLEAR", Coerce::None, 0, 0, getCalSaved<0>, clearCal<0>},      // also erases the saved sweep
+        {"FLEX_3", "CAL_CLEAR", Coerce::None, 0, 0, getCalSaved<1>, clearCal<1>},
+        {"FLEX_4", "CAL_CLEAR", Coerce::None, 0, 0, getCalSaved<2>, clearCal<2>},
+        {"FLEX_5", "CAL_CLEAR", Coerce::None, 0, 0, getCalSaved<3>, clearCal<3>},
+        // ------ STREAM: FORMAT belongs to the requesting client; the rest are shared by all clients
+        {"STREAM", "FORMAT", Coerce::Text, 0, 0,                    // JSON/BINARY (see 'StreamProtocol.h'), per client.
+            [](WebSocketBridge &b, const Command &c, const uint32_t to) {
+                if (const Session *self = b.findClient(to); self != nullptr) {
+                    b.composeGetResponse(c.dev, c.attr, stream::formatString(self->format.load()));
                 }
-            } break; // end Device::Flex case (static)
-            default: {
-                // search through all sensors, attempting to compare in buffer's device field to the sensors name.
-                bool found = false;
-                auto attr = parseFlexNAttr();
-                int i = 0; // store index where found sensor occurred
-                for (auto &sensor : sensors) {
-                    if (strcmp(sensor.getName(), inBuffer["dev"].as<const char *>()) == 0) {
-                        found = true;
-                        break;
-                    }
-                    i++;
+            },
+            [](WebSocketBridge &b, const Arg &a) {
+                Session *self = b.findClient(b.requester_);
+                const auto format = stream::formatFromString(a.text);
+                if (self == nullptr || format == stream::Format::INVALID_FORMAT) return ERROR;
+                self->format.store(format);
+                return OK;
+            }},
+        {"STREAM", "SUBSCRIBE", Coerce::Text, 0, 0,                 // Comma-separated FLEX/SERVO/CONFIG, per client.
+            [](WebSocketBridge &b, const Command &c, const uint32_t to) {
+                if (const Session *self = b.findClient(to); self != nullptr) {
+                    char list[24];
+                    b.composeGetResponse(c.dev, c.attr, stream::subscriptionString(self->subscriptions.load(), list));
                 }
-                if (found) {
-                    if (attr == FlexNAttr::Pin) { // pin attr
-                        if (req == Method::GET) { // request to get the pin number
-                            sendGetResponse(sensors[i].getName(), "PIN", sensors[i].getPin().value_or(false));
-                        } else {
-                            // attempt reinterpreting false pin value to std::nullopt
-                            auto v = inBuffer["val"];
-                            // 1) bool `false` -> detach
-                            if (v.is<bool>() && v.as<bool>() == false) {
-                                sensors[i].setPin(std::nullopt);
-                                sendSetResponse(&ws_.getClients().front(), OK);
-                            }
-                            // 2) numeric -> pin number
-                            else if (v.is<long>()) {
-                                const auto pinNum = v.as<long>();
-                                if (sensors[i].setPin(static_cast<uint16_t>(pinNum))) {
-                                    sendSetResponse(&ws_.getClients().front(), OK);
-                                } else {
-                                    sendSetResponse(&ws_.getClients().front(), ERROR);
-                                }
-                            }
-                            // 3) string “false” -> detach
-                            else if (v.is<const char*>()) {
-                                const auto s = v.as<const char*>();
-                                if (strcmp(s, "false") == 0) {
-                                    sensors[i].setPin(std::nullopt);
-                                    sendSetResponse(&ws_.getClients().front(), OK);
-                                }
-                                else {
-                                    sendInvalidAttr(&ws_.getClients().front());
-                                }
-                            }
-                            else {
-                                sendInvalidAttr(&ws_.getClients().front());
-                            }
-                        }
-                    }
-                } else {
-                    sendSetResponse(&ws_.getClients().front(), ERROR);
+            },
+            [](WebSocketBridge &b, const Arg &a) {
+                Session *self = b.findClient(b.requester_);
+                uint8_t mask;
+                if (self == nullptr || !stream::parseSubscriptions(a.text, mask)) return ERROR;
+                self->subscriptions.store(mask);
+                return OK;
+            }},
+        {"STREAM", "MAX_RATE", Coerce::Int, 1, 1000,                // Cap on streamed messages per second (Hz).
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.maxSendRate_); },
+            [](WebSocketBridge &b, const Arg &a) { b.maxSendRate_ = a.number; return OK; }},
+        {"STREAM", "SKIPPED", Coerce::None, 0, 0,                   // Sends skipped because a client's queue was backed up.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.sendSkips_.load()); },
+            nullptr},
+        {"STREAM", "FRAME_DROPS", Coerce::None, 0, 0,               // Frames dropped because the network task fell behind.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.frames_.overruns()); },
+            nullptr},
+        {"STREAM", "RX_DROPS", Coerce::None, 0, 0,                  // Requests dropped (no free slot, or too long).
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.requests_.drops() + b.requests_.oversize()); },
+            nullptr},
+        // ------ HEAP: memory counters (read-only)
+        {"HEAP", "FREE", Coerce::None, 0, 0,                        // Free heap right now (bytes).
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, ESP.getFreeHeap()); },
+            nullptr},
+        {"HEAP", "MIN_FREE", Coerce::None, 0, 0,                    // Least free heap since boot, i.e. the heap high-water mark.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, ESP.getMinFreeHeap()); },
+            nullptr},
+        {"HEAP", "IN_PEAK", Coerce::None, 0, 0,                     // Most of the request arena ever used (bytes).
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.inArena_.peak()); },
+            nullptr},
+        {"HEAP", "OUT_PEAK", Coerce::None, 0, 0,                    // Most of the response arena ever used (bytes).
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.outArena_.peak()); },
+            nullptr},
+        {"HEAP", "ARENA_FAILS", Coerce::None, 0, 0,                 // Allocations refused because an arena was full.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.inArena_.failures() + b.outArena_.failures()); },
+            nullptr},
+        // ------ LOG: serial log rate caps (see 'SerialStream.h')
+        {"LOG", "RATE", Coerce::Int, 0, 1000,                       // sr::out lines per second (0 = no cap).
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, sr::getRateLimit(sr::Level::INFO)); },
+            [](WebSocketBridge &, const Arg &a) { sr::setRateLimit(sr::Level::INFO, a.number); return OK; }},
+        {"LOG", "DEBUG_RATE", Coerce::Int, 0, 1000,                 // sr::debug lines per second (0 = no cap).
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, sr::getRateLimit(sr::Level::DEBUG)); },
+            [](WebSocketBridge &, const Arg &a) { sr::setRateLimit(sr::Level::DEBUG, a.number); return OK; }},
+        {"LOG", "DROPS", Coerce::None, 0, 0,                        // Lines dropped (over the cap, or the ring was full).
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, sr::dropped()); },
+            nullptr},
+        // ------ STATS: latency histograms and counters (see 'Metrics.h'; also served as GET /metrics)
+        {"STATS", "ALL", Coerce::None, 0, 0,                        // Everything, as one message (layout in 'commands.txt').
+            [](WebSocketBridge &b, const Command &c, const uint32_t) {
+                if (const size_t n = b.encodeStats(); n > 0) b.composeReply(b.txText_, n);
+                else b.composeErrorResponse(c.dev, c.attr); // too big for txText_; already logged
+            },
+            nullptr, true},                                         // atomics only: encoded without devices_
+        {"STATS", "RESET", Coerce::None, 0, 0,                      // Empty the histograms (counters keep counting).
+            nullptr,
+            [](WebSocketBridge &b, const Arg &) {
+                for (auto &histogram : b.latency_) histogram.reset();
+                return OK;
+            }},
+        // ------ TASKS: per-task CPU load and stack headroom (see 'TaskMonitor.h'; also in GET /metrics)
+        {"TASKS", "ALL", Coerce::None, 0, 0,                        // The latest sample, as one message (layout in 'commands.txt').
+            [](WebSocketBridge &b, const Command &c, const uint32_t) {
+                if (const size_t n = b.encodeTasks(); n > 0) b.composeReply(b.txText_, n);
+                else b.composeErrorResponse(c.dev, c.attr); // too big for txText_; already logged
+            },
+            nullptr, true},                                         // TaskMonitor's own lock: encoded without devices_
+        {"TASKS", "PERIOD", Coerce::Int, TaskMonitor::MIN_PERIOD, TaskMonitor::MAX_PERIOD, // Time between samples (ms).
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.tasks_.getPeriod()); },
+            [](WebSocketBridge &b, const Arg &a) { b.tasks_.setPeriod(a.number); return OK; }},
+        // ------ CONTROL: on-device flex -> servo control (see 'AssistController.h'), run once per frame
+        {"CONTROL", "MODE", Coerce::Text, 0, 0,                     // OFF/MAP/PID/ASSIST. Any change restarts the controller.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, AssistController::modeString(b.control_.getMode())); },
+            [](WebSocketBridge &b, const Arg &a) {
+                const auto mode = AssistController::modeFromString(a.text);
+                if (mode == AssistController::INVALID_MODE) return ERROR;
+                b.control_.setMode(mode);
+                return OK;
+            }},
+        {"CONTROL", "CHANNELS", Coerce::Int, 1, 15,                 // Sensors averaged into the measured angle (bit i = FLEX_(i + 2)).
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.control_.getChannels()); },
+            [](WebSocketBridge &b, const Arg &a) { b.control_.setChannels(a.number); return OK; }},
+        {"CONTROL", "TARGET", Coerce::Int, 0, 180,                  // Finger angle (º) PID and ASSIST aim for.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.control_.getTarget()); },
+            [](WebSocketBridge &b, const Arg &a) { b.control_.setTarget(a.number); return OK; }},
+        {"CONTROL", "GAIN", Coerce::Int, -AssistController::MAX_MAP_GAIN, AssistController::MAX_MAP_GAIN, // Servo º per finger º (‰).
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.control_.getGain()); },
+            [](WebSocketBridge &b, const Arg &a) { b.control_.setGain(a.number); return OK; }},
+        {"CONTROL", "OFFSET", Coerce::Int, -360, 360,               // Servo angle (º) at a finger angle of 0.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.control_.getOffset()); },
+            [](WebSocketBridge &b, const Arg &a) { b.control_.setOffset(a.number); return OK; }},
+        {"CONTROL", "KP", Coerce::Int, 0, AssistController::MAX_GAIN, // Proportional gain (‰).
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.control_.getKp()); },
+            [](WebSocketBridge &b, const Arg &a) { b.control_.setKp(a.number); return OK; }},
+        {"CONTROL", "KI", Coerce::Int, 0, AssistController::MAX_GAIN, // Integral gain (‰ per s). Clears the integral.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.control_.getKi()); },
+            [](WebSocketBridge &b, const Arg &a) { b.control_.setKi(a.number); return OK; }},
+        {"CONTROL", "KD", Coerce::Int, 0, AssistController::MAX_GAIN, // Derivative gain (‰ · s), on the measurement.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.control_.getKd()); },
+            [](WebSocketBridge &b, const Arg &a) { b.control_.setKd(a.number); return OK; }},
+        {"CONTROL", "DEADBAND", Coerce::Int, 0, AssistController::MAX_DEADBAND, // ASSIST: error (º) left to the patient.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.control_.getDeadband()); },
+            [](WebSocketBridge &b, const Arg &a) { b.control_.setDeadband(a.number); return OK; }},
+        {"CONTROL", "ERROR", Coerce::None, 0, 0,                    // Target - measured angle at the last frame (0.01º).
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.control_.getError()); },
+            nullptr},
+        {"CONTROL", "HOLDS", Coerce::None, 0, 0,                    // Frames the servo was held for: no selected sensor calibrated.
+            [](WebSocketBridge &b, const Command &c, const uint32_t) { b.composeGetResponse(c.dev, c.attr, b.control_.getHolds()); },
+            nullptr},
+    };
+    static constexpr auto INDEX = cmd::perfectHash(ROWS);
+    static_assert(INDEX.found, "No perfect hash for the command table; change cmd::SALT");
+
+    static const Command *find(const char *dev, const char *attr) { return cmd::find(ROWS, INDEX, dev, attr); }
+    /* Coerce a SET request's "val" for a row. Returns false if it's missing, the wrong type or out of range. */
+    static bool coerce(const Command &command, const JsonVariantConst val, Arg &arg) {
+        switch (command.type) {
+            case Coerce::None:
+                return true;
+            case Coerce::Bool:
+                if (!val.is<bool>()) return false;
+                arg.number = val.as<bool>();
+                return true;
+            case Coerce::Text:
+                arg.text = val.as<const char *>();
+                return arg.text != nullptr;
+            case Coerce::Pin:
+                if ((val.is<bool>() && !val.as<bool>()) || (val.is<const char *>() && strcmp(val.as<const char *>(), "false") == 0)) {
+                    arg.detach = true; // false/"false" disconnects
+                    return true;
                 }
-            } break;
+                [[fallthrough]];
+            case Coerce::Int:
+                if (!val.is<long>() && !val.is<double>()) return false;
+                arg.number = val.as<long>();
+                return arg.number >= command.min && arg.number <= command.max;
         }
-    } else {
-        sendInvalidRequest(&ws_.getClients().front());
+        return false;
     }
+};
+#ifndef ARDUINO
+/* ------ Command table access for the native benchmarks (see 'src/native/DispatchBench.cpp') ------ */
+size_t WebSocketBridge::commandKeys(CommandKey *keys, const size_t capacity) {
+    const size_t count = sizeof(Commands::ROWS) / sizeof(Commands::ROWS[0]);
+    for (size_t i = 0; i < count && i < capacity; i++) keys[i] = {Commands::ROWS[i].dev, Commands::ROWS[i].attr};
+    return count;
+}
+bool WebSocketBridge::hasCommand(const char *dev, const char *attr) {
+    return Commands::find(dev, attr) != nullptr;
 }
+#endif
 
+// set related fields of the inBuffer JSON from received fields
+void WebSocketBridge::handleReceived(const uint32_t clientId, char *request, const size_t length) {
+    metrics::Scope probe(latency_[metrics::REQUEST]); // parsing, the command and its reply
+    requester_ = clientId;
+    sr::debug << "Received: " << request << sr::endl;
+    inBuffer.clear();
+    DeserializationError error = deserializeJson(inBuffer, request, length); // parsed straight from the slot
+    if (error) {
+        sr::warn << "Failed to parse request: " << error.c_str() << sr::endl; // NoMemory if it outgrew inArena_
+        return;
+    }
+    AsyncWebSocketClient *client = ws_.client(clientId);
+    if (client == nullptr) return; // sender disconnected while the request was queued
+    const auto req = parseMethod();
+    if (req == Method::INVALID_METHOD) {
+        sendInvalidRequest(client);
+        return;
+    }
+    const Command *command = Commands::find(inBuffer["dev"], inBuffer["attr"]);
+    if (command == nullptr) {
+        sendInvalidAttr(client); // unknown device or attribute
+        return;
+    }
+    if (req == Method::GET) {
+        if (command->get == nullptr) {
+            sendInvalidAttr(client); // write-only
+            return;
+        }
+        reply_ = nullptr;
+        if (command->unlocked) {
+            command->get(*this, *command, clientId);
+        } else {
+            DeviceLock lock(devices_); // only the getter; parsing above and sending below run without it
+            command->get(*this, *command, clientId);
+        }
+        sendReply(client);
+        return;
+    }
+    if (command->set == nullptr) {
+        sendInvalidAttr(client); // read-only
+        return;
+    }
+    Arg arg{};
+    if (!Commands::coerce(*command, inBuffer["val"], arg)) {
+        sendSetResponse(client, ERROR);
+        return;
+    }
+    Status status;
+    {
+        DeviceLock lock(devices_); // only the setter
+        status = command->set(*this, arg);
+    }
+    sendSetResponse(client, status);
+    if (status == OK) broadcastChange(*command); // keep the other dashboards in sync
+}
@@ -1,15 +1,13 @@
 #include <Arduino.h>
 #include "WebSocketBridge.h"
-#ifndef PRINT_DEBUG
-    #define PRINT_DEBUG // Comment this line out to hide debugging.
-#endif
+// Debugging statements are enabled with a build flag (SR_LEVEL in platformio.ini), not a #define here.
 
 WebSocketBridge ws;
 void setup() {
     try {
         ws.setup();
     } catch (...) {
-        sr::out << "Failed to start WebSocket server. " << sr::endl;
+        sr::error << "Failed to start WebSocket server. " << sr::endl;
         esp_deep_sleep_start();
     }
 }
@@ -0,0 +1,96 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Command dispatch benchmark: the bridge's hash lookup (see 'CommandTable.h') against the strcmp dispatch it replaced,
+ *  on a corpus of the bridge's own (dev, attr) pairs.
+ *      >> The strcmp dispatch has the shape of the old parseDevice()/parseXxxAttr() chains: compare the device name
+ *         against each device in turn, then the attribute against each of that device's attributes. It is built from
+ *         the same rows, so both cover every current command.
+ *      >> The corpus is every row once plus UNKNOWN_SHARE of misspelled or unknown keys (a stale page, a typo), in
+ *         a fixed shuffled order, looked up LOOKUPS times in total. Both dispatches must agree on every key; the run
+ *         fails otherwise.
+ *      >> ns_per_lookup is host time, for comparing the two and changes to them, not a board figure.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#include <Arduino.h>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "WebSocketBridge.h"
+#include "Bench.h"
+
+namespace {
+    constexpr size_t MAX_ROWS = 256;
+    constexpr size_t LOOKUPS = 2000000;
+    constexpr double UNKNOWN_SHARE = 0.1;
+    constexpr WebSocketBridge::CommandKey UNKNOWN[] = {
+        {"SERVO", "SPEED"}, {"SERVO", "POS"}, {"FLEX_6", "PIN"}, {"FLEX", "RATE"}, {"STREAM", "FORMATS"},
+        {"LED", "ON"}, {"CONTROL", "KF"}, {"servo", "POSITION"}, {"", ""}, {"TASKS", "ALL_"},
+    };
+
+    struct Device {
+        const char *name;
+        std::vector<const char *> attrs;
+    };
+
+    bool strcmpDispatch(const std::vector<Device> &devices, const char *dev, const char *attr) {
+        for (const Device &device : devices) {
+            if (strcmp(device.name, dev) != 0) continue;
+            for (const char *a : device.attrs) {
+                if (strcmp(a, attr) == 0) return true;
+            }
+            return false;
+        }
+        return false;
+    }
+
+    template <typename Lookup>
+    double time(const std::vector<WebSocketBridge::CommandKey> &corpus, Lookup lookup, size_t &hits) {
+        hits = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t n = 0; n < LOOKUPS; n++) {
+            const auto &key = corpus[n % corpus.size()];
+            hits += lookup(key.dev, key.attr);
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / LOOKUPS;
+    }
+}
+
+bool bench::dispatch() {
+    WebSocketBridge::CommandKey keys[MAX_ROWS];
+    const size_t rows = WebSocketBridge::commandKeys(keys, MAX_ROWS);
+    std::vector<Device> devices;
+    for (size_t i = 0; i < rows && i < MAX_ROWS; i++) {
+        Device *device = nullptr;
+        for (Device &d : devices) {
+            if (strcmp(d.name, keys[i].dev) == 0) device = &d;
+        }
+        if (device == nullptr) device = &devices.emplace_back(Device{keys[i].dev, {}});
+        device->attrs.push_back(keys[i].attr);
+    }
+    std::vector<WebSocketBridge::CommandKey> corpus(keys, keys + (rows < MAX_ROWS ? rows : MAX_ROWS));
+    const auto unknown = static_cast<size_t>(static_cast<double>(corpus.size()) * UNKNOWN_SHARE + 0.5);
+    for (size_t i = 0; i < unknown; i++) corpus.push_back(UNKNOWN[i % (sizeof(UNKNOWN) / sizeof(UNKNOWN[0]))]);
+    std::shuffle(corpus.begin(), corpus.end(), std::mt19937(4920));
+
+    uint32_t mismatches = 0;
+    for (const auto &key : corpus) {
+        if (strcmpDispatch(devices, key.dev, key.attr) != WebSocketBridge::hasCommand(key.dev, key.attr)) mismatches++;
+    }
+    size_t strcmpHits = 0;
+    size_t hashHits = 0;
+    const double strcmpNs = time(corpus, [&](const char *dev, const char *attr) {
+        return strcmpDispatch(devices, dev, attr);
+    }, strcmpHits);
+    const double hashNs = time(corpus, WebSocketBridge::hasCommand, hashHits);
+    const bool ok = mismatches == 0 && strcmpHits == hashHits && rows <= MAX_ROWS;
+    printf("dispatch rows=%zu devices=%zu corpus=%zu unknown=%zu lookups=%zu strcmp_ns_per_lookup=%.1f "
+           "hash_ns_per_lookup=%.1f speedup=%.2f mismatches=%u %s\n",
+           rows, devices.size(), corpus.size(), unknown, LOOKUPS, strcmpNs, hashNs,
+           hashNs > 0.0 ? strcmpNs / hashNs : 0.0, mismatches, ok ? "PASS" : "FAIL");
+    return ok;
+}
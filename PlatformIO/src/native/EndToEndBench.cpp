@@ -0,0 +1,158 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *  End-to-end latency benchmark: one reading's trip from the ADC read in FlexSensorArray's timer to the decoded sample a
+ *  dashboard would push into its TimeSeries. The unchanged WebSocketBridge runs against the simulated board and the
+ *  in-process WebSocket stand-in (see 'include/native/ESPAsyncWebServer.h'), and a headless client decodes what it
+ *  receives the way script.js does. Each reading is stamped at:
+ *      acquired    the frame's timestamp, taken by the timer callback at the start of the scan
+ *      enqueued    the bridge handing the batch to AsyncWebSocketClient::text()/binary(). Serialization happens in
+ *                  the same loop() pass, right before, so the two share one stamp in simulated time.
+ *      received    the link delivering the message to the client (see the stand-in's link model)
+ *  plus the host CPU time the client spends decoding each message. Every configuration is run for both stream
+ *  formats, since batching, message size and decoding all differ between them.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+#include <chrono>
+#include <cstdio>
+#include "WebSocketBridge.h"
+#include "StreamProtocol.h"
+#include "Sim.h"
+#include "Bench.h"
+
+namespace {
+    constexpr uint64_t DRAIN_TIME = 500000;                     // Simulated time allowed for queues to empty after a run (µs)
+
+    /* ------ Headless dashboard: decodes BATCH messages and keeps the per-reading stamps ------ */
+    struct HeadlessClient {
+        std::vector<uint64_t> toEnqueue;                        // acquired -> enqueued (µs)
+        std::vector<uint64_t> toReceive;                        // enqueued -> received (µs)
+        std::vector<uint64_t> total;                            // acquired -> received (µs)
+        std::vector<uint64_t> decodeNs;                         // Host time to decode one message (ns)
+        uint64_t records = 0;
+        uint64_t bytes = 0;
+        uint32_t gaps = 0;
+        bool first = true;
+        uint32_t lastSequence = 0;
+        JsonDocument doc;
+
+        void onMessage(const WsMessage &message) {
+            bytes += message.data.size();
+            const auto start = std::chrono::steady_clock::now();
+            struct Sample { uint32_t sequence; uint64_t timestamp; } samples[UINT8_MAX]; // a batch's count is one byte
+            const size_t count = message.binary ? decodeBinary(message, samples) : decodeJson(message, samples);
+            decodeNs.push_back(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count()));
+            for (size_t i = 0; i < count; i++) record(samples[i].sequence, samples[i].timestamp, message);
+        }
+        /* Same walk as WSClient._onBinary in script.js. */
+        template <typename Sample>
+        size_t decodeBinary(const WsMessage &message, Sample *samples) {
+            const uint8_t *p = message.data.data();
+            if (message.data.size() < stream::BATCH_HEADER_SIZE || p[0] != stream::BATCH) return 0;
+            const size_t count = p[1];
+            if (message.data.size() < stream::batchSize(count)) return 0;
+            for (size_t i = 0; i < count; i++) {
+                const uint8_t *r = p + stream::BATCH_HEADER_SIZE + i * stream::FLEX_RECORD_SIZE;
+                samples[i].sequence = get32(r + 1);
+                samples[i].timestamp = get32(r + 5) | static_cast<uint64_t>(get32(r + 9)) << 32;
+            }
+            return count;
+        }
+        /* Same fields as the 'BATCH' case of WSClient's message handler in script.js. */
+        template <typename Sample>
+        size_t decodeJson(const WsMessage &message, Sample *samples) {
+            if (deserializeJson(doc, reinterpret_cast<const char *>(message.data.data()), message.data.size())) return 0;
+            const char *dev = doc["dev"];
+            if (dev == nullptr || strcmp(dev, "BATCH") != 0) return 0; // snapshots and replies
+            size_t count = 0;
+            for (JsonVariantConst frame : doc["flex"].as<JsonArrayConst>()) {
+                if (count == UINT8_MAX) break;
+                samples[count].sequence = frame["seq"].as<uint32_t>();
+                samples[count].timestamp = frame["ts"].as<uint64_t>();
+                count++;
+            }
+            return count;
+        }
+        void record(const uint32_t sequence, const uint64_t acquired, const WsMessage &message) {
+            toEnqueue.push_back(message.queuedAt - acquired);
+            toReceive.push_back(message.deliverAt - message.queuedAt);
+            total.push_back(message.deliverAt - acquired);
+            if (!first) gaps += sequence - lastSequence - 1;
+            lastSequence = sequence;
+            first = false;
+            records++;
+        }
+        static uint32_t get32(const uint8_t *p) {
+            return p[0] | p[1] << 8 | p[2] << 16 | static_cast<uint32_t>(p[3]) << 24;
+        }
+    };
+
+    void runUntil(WebSocketBridge &bridge, AsyncWebSocket &ws, const uint64_t end) {
+        while (sim::now() < end) {
+            bridge.loop();                                      // its delay(1) advances the clock
+            ws.deliver();
+        }
+    }
+
+    void command(WebSocketBridge &bridge, AsyncWebSocket &ws, AsyncWebSocketClient *client, const char *request) {
+        ws.send(client, request);
+        bridge.loop();                                          // requests are handled on the next pass
+        ws.deliver();
+    }
+
+    void run(WebSocketBridge &bridge, AsyncWebSocket &ws, const char *format, const uint64_t interval, const uint64_t seconds) {
+        HeadlessClient headless;
+        AsyncWebSocketClient *client = ws.connect();
+        client->onMessage = [&headless](const WsMessage &message) { headless.onMessage(message); };
+        char request[128];
+        snprintf(request, sizeof(request), R"({"dev":"STREAM","req":"SET","attr":"FORMAT","val":"%s"})", format);
+        command(bridge, ws, client, request);
+        snprintf(request, sizeof(request), R"({"dev":"FLEX","req":"SET","attr":"SAMPLE_RATE","val":%llu})",
+                 static_cast<unsigned long long>(interval));
+        command(bridge, ws, client, request);
+        command(bridge, ws, client, R"({"dev":"FLEX","req":"SET","attr":"START"})");
+
+        const auto start = std::chrono::steady_clock::now();
+        runUntil(bridge, ws, sim::now() + seconds * 1000000);
+        command(bridge, ws, client, R"({"dev":"FLEX","req":"SET","attr":"STOP"})");
+        runUntil(bridge, ws, sim::now() + DRAIN_TIME);
+        const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ws.disconnect(client);
+
+        printf("e2e format=%s interval=%llu records=%llu rate=%.1f bytes_per_s=%.0f "
+               "acq_enq_p50=%llu p99=%llu p999=%llu enq_rx_p50=%llu p99=%llu p999=%llu "
+               "total_p50=%llu p99=%llu p999=%llu decode_ns_p50=%llu p99=%llu gaps=%u speedup=%.0fx\n",
+               format, static_cast<unsigned long long>(interval), static_cast<unsigned long long>(headless.records),
+               static_cast<double>(headless.records) / seconds, static_cast<double>(headless.bytes) / seconds,
+               static_cast<unsigned long long>(bench::percentile(headless.toEnqueue, 0.50)),
+               static_cast<unsigned long long>(bench::percentile(headless.toEnqueue, 0.99)),
+               static_cast<unsigned long long>(bench::percentile(headless.toEnqueue, 0.999)),
+               static_cast<unsigned long long>(bench::percentile(headless.toReceive, 0.50)),
+               static_cast<unsigned long long>(bench::percentile(headless.toReceive, 0.99)),
+               static_cast<unsigned long long>(bench::percentile(headless.toReceive, 0.999)),
+               static_cast<unsigned long long>(bench::percentile(headless.total, 0.50)),
+               static_cast<unsigned long long>(bench::percentile(headless.total, 0.99)),
+               static_cast<unsigned long long>(bench::percentile(headless.total, 0.999)),
+               static_cast<unsigned long long>(bench::percentile(headless.decodeNs, 0.50)),
+               static_cast<unsigned long long>(bench::percentile(headless.decodeNs, 0.99)),
+               headless.gaps, wall > 0 ? static_cast<double>(seconds) / wall : 0.0);
+    }
+}
+
+void bench::endToEnd(const uint64_t seconds, const uint32_t jitter) {
+    sim::reset();
+    sim::setTimerJitter(jitter);
+    static WebSocketBridge bridge;                              // several KB of buffers; keep it off the stack
+    bridge.setup();
+    AsyncWebSocket *ws = AsyncWebSocket::find("/ws");
+    if (ws == nullptr) return;
+    for (const char *format : {"BINARY", "JSON"}) {
+        for (const uint64_t interval : INTERVALS) run(bridge, *ws, format, interval, seconds);
+    }
+}
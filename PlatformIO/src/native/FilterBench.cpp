@@ -0,0 +1,130 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Filter benchmark: the fixed-point kernels in 'FlexFilter.h' against a double-precision reference of the same chain
+ *  (average of N reads -> one-pole low-pass with the exact α -> mean of M scans), fed the simulator's finger signal.
+ *      >> err_max is the largest difference between the two outputs in ADC counts, after both are rounded to 12 bits.
+ *         Anything above MAX_ERROR (1 count) means the fixed-point path lost resolution somewhere, and the line ends
+ *         with FAIL and the check fails; every other line ends with PASS.
+ *      >> ns_per_scan is host time for one channel's kernels per scan, for comparing changes to them, not a board
+ *         figure. The array run after it checks the frame rate and spacing FlexSensorArray actually produces.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#include <Arduino.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include "FlexFilter.h"
+#include "FlexSensorArray.h"
+#include "Sim.h"
+#include "Bench.h"
+
+namespace {
+    constexpr uint64_t LOOP_PERIOD = 1000;                      // Simulated time between loop() calls (µs)
+    constexpr uint64_t READ_SPACING = 25;                       // Time between the reads of one scan (µs)
+    constexpr int MAX_ERROR = 1;                                // Largest err_max that passes (ADC counts)
+
+    struct Config {
+        uint8_t oversample;
+        uint32_t cutoff;                                        // mHz
+        uint8_t decimation;
+    };
+    constexpr Config CONFIGS[] = {{1, 0, 1}, {4, 0, 1}, {16, 0, 1}, {1, 5000, 1}, {4, 5000, 4}, {16, 2000, 16}};
+
+    uint8_t log2(const uint8_t n) {
+        uint8_t shift = 0;
+        while ((1u << shift) < n) shift++;
+        return shift;
+    }
+
+    bool runKernels(const uint64_t interval, const Config &config, const uint64_t seconds) {
+        const uint8_t shift = log2(config.oversample);
+        const uint32_t alpha = dsp::lowPassAlpha(config.cutoff, interval);
+        const double exactAlpha = config.cutoff == 0 ? 1.0
+            : 1.0 - std::exp(-2.0 * M_PI * (config.cutoff / 1000.0) * (static_cast<double>(interval) / 1e6));
+        dsp::LowPass filter{};
+        dsp::Decimator decimator{};
+        double y = 0.0, sum = 0.0;
+        bool primed = false;
+        uint8_t count = 0;
+        uint64_t outputs = 0;
+        int errMax = 0;
+        uint64_t kernelNs = 0;
+        const uint64_t scans = seconds * 1000000 / interval;
+        for (uint64_t n = 0; n < scans; n++) {
+            const uint64_t t = n * interval;
+            uint32_t reads = 0;
+            for (uint8_t k = 0; k < config.oversample; k++) reads += sim::fingerFlex(0, t + k * READ_SPACING);
+            // reference
+            const double x = static_cast<double>(reads) / config.oversample;
+            y = primed ? y + exactAlpha * (x - y) : x;
+            primed = true;
+            sum += y;
+            // fixed point
+            const auto start = std::chrono::steady_clock::now();
+            decimator.add(filter.step(dsp::fromSum(reads, shift), alpha));
+            bool ready = ++count == config.decimation;
+            int32_t fixed = 0;
+            if (ready) fixed = decimator.take();
+            kernelNs += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+            if (!ready) continue;
+            const auto reference = static_cast<int>(std::lround(std::min(std::max(sum / count, 0.0), 4095.0)));
+            errMax = std::max(errMax, std::abs(static_cast<int>(dsp::toReading(fixed)) - reference));
+            sum = 0.0;
+            count = 0;
+            outputs++;
+        }
+        const bool ok = errMax <= MAX_ERROR;
+        printf("filter interval=%llu oversample=%u cutoff_mhz=%u decimate=%u alpha_q16=%u outputs=%llu err_max=%d "
+               "ns_per_scan=%.1f %s\n",
+               static_cast<unsigned long long>(interval), config.oversample, config.cutoff, config.decimation, alpha,
+               static_cast<unsigned long long>(outputs), errMax,
+               scans != 0 ? static_cast<double>(kernelNs) / static_cast<double>(scans) : 0.0, ok ? "PASS" : "FAIL");
+        return ok;
+    }
+
+    void runArray(const uint64_t interval, const Config &config, const uint64_t seconds) {
+        sim::reset();
+        sim::setAdcConversionTime(READ_SPACING);
+        FlexSensorArray sensors;
+        uint64_t frames = 0;
+        uint64_t lastTimestamp = 0;
+        uint64_t spacingMax = 0;
+        sensors.setFrameNotifier([&](const FlexSensorArray::Frame &frame) {
+            if (frames != 0) spacingMax = std::max(spacingMax, frame.timestamp - lastTimestamp);
+            lastTimestamp = frame.timestamp;
+            frames++;
+        });
+        sensors.setup();
+        for (uint8_t i = 0; i < FlexSensorArray::SIZE; i++) sensors[i].setPin(A0 + i);
+        sensors.setSamplingInterval(interval);
+        const bool accepted = sensors.setOversample(config.oversample) && sensors.setCutoff(config.cutoff)
+                            && sensors.setDecimation(config.decimation);
+        sensors.setActive(true);
+        const uint64_t end = sim::now() + seconds * 1000000;
+        while (sim::now() < end) {
+            sim::advance(LOOP_PERIOD);
+            sensors.loop();
+        }
+        sensors.setActive(false);
+        printf("filter_array interval=%llu oversample=%u cutoff_mhz=%u decimate=%u accepted=%d frames=%llu rate=%.1f "
+               "spacing_max=%llu adc_reads=%llu overruns=%u\n",
+               static_cast<unsigned long long>(interval), config.oversample, config.cutoff, config.decimation,
+               accepted, static_cast<unsigned long long>(frames), static_cast<double>(frames) / seconds,
+               static_cast<unsigned long long>(spacingMax), static_cast<unsigned long long>(sim::adcReads()),
+               sensors.getOverruns());
+    }
+}
+
+bool bench::filter(const uint64_t seconds) {
+    bool ok = true;
+    for (const uint64_t interval : INTERVALS) {
+        for (const Config &config : CONFIGS) ok &= runKernels(interval, config, seconds);
+    }
+    for (const Config &config : CONFIGS) runArray(1000, config, seconds);
+    return ok;
+}
@@ -0,0 +1,111 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  JSON batch benchmark: the bridge's encodeJsonBatch() (see 'JsonWriter.h') against the JsonDocument + serializeJson()
+ *  path it replaced, in messages per second.
+ *      >> The old path is rebuilt here as it was: the batch built in a JsonDocument on a JsonArena (6 KB, as outArena_
+ *         was then), then serialized into a buffer the size of txText_. It writes the current layout, "ang" included.
+ *      >> Both encode the same frames: all sensors connected, a quarter of the angles uncalibrated (null), timestamps
+ *         past 2^32 µs (71 minutes of uptime) so the 64-bit path is covered. Each batch size runs with and without a
+ *         servo angle.
+ *      >> Both must produce the same bytes for every message; the run fails otherwise.
+ *      >> msgs_per_s is host time, for comparing the two and changes to them, not a board figure.
+ *  Host results so far (x86-64, -O2, two runs), writer side only: 1 frame (118 bytes) 10 – 13 M msgs/s, 4 frames
+ *  (412 bytes) 2.1 – 2.6 M msgs/s, 16 frames (1575 bytes) 0.61 – 0.66 M msgs/s; the servo angle costs ~10 %. The
+ *  JsonDocument column hasn't been measured yet: it needs ArduinoJson from the native lib_deps, which the machine
+ *  these were taken on couldn't download. `pio run -e native && .pio/build/native/program json` fills in both.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include "WebSocketBridge.h"
+#include "JsonArena.h"
+#include "Bench.h"
+
+namespace {
+    constexpr size_t MESSAGES = 20000;                          // Messages encoded per path and configuration
+    constexpr size_t BATCH_SIZES[] = {1, 4, 16};                // Frames per message (16 is BATCH_CAPACITY)
+    constexpr size_t TEXT_SIZE = 2048;                          // sizeof(txText_)
+    constexpr uint64_t START_TIME = 5000000000;                 // First frame's timestamp (µs)
+
+    /* ------ The replaced path: build the document, then serialize it ------ */
+    struct DocumentEncoder {
+        JsonArena<6144> arena;
+        JsonDocument doc{&arena};
+        char text[TEXT_SIZE];
+
+        size_t encode(const FlexSensorArray::Frame *batch, const size_t count, const int servo) {
+            doc.clear();
+            doc["dev"] = "BATCH";
+            JsonArray frames = doc["flex"].to<JsonArray>();
+            for (size_t i = 0; i < count; i++) {
+                JsonObject frame = frames.add<JsonObject>();
+                frame["seq"] = batch[i].sequence;
+                frame["ts"] = batch[i].timestamp;
+                frame["mask"] = batch[i].mask;
+                JsonArray val = frame["val"].to<JsonArray>();
+                for (const uint16_t reading : batch[i].readings) val.add(reading);
+                JsonArray ang = frame["ang"].to<JsonArray>();
+                for (const int16_t angle : batch[i].angles) {
+                    if (angle == FlexCalibration::NO_ANGLE) ang.add(nullptr);
+                    else ang.add(angle);
+                }
+            }
+            if (servo >= 0) doc["servo"] = servo;
+            if (doc.overflowed()) return 0;
+            return serializeJson(doc, text, sizeof(text));
+        }
+    };
+
+    template <typename Encode>
+    double rate(Encode encode, size_t &bytes) {
+        bytes = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t n = 0; n < MESSAGES; n++) bytes += encode();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return seconds > 0.0 ? static_cast<double>(MESSAGES) / seconds : 0.0;
+    }
+}
+
+bool bench::json() {
+    static WebSocketBridge bridge;                              // several KB of buffers; keep it off the stack
+    static DocumentEncoder document;
+    std::mt19937 random(4920);
+    FlexSensorArray::Frame frames[BATCH_SIZES[2]];
+    for (size_t i = 0; i < BATCH_SIZES[2]; i++) {
+        frames[i] = {START_TIME + i * 1000, static_cast<uint32_t>(100000 + i), (1u << FlexSensorArray::SIZE) - 1, {}, {}};
+        for (size_t j = 0; j < FlexSensorArray::SIZE; j++) {
+            frames[i].readings[j] = static_cast<uint16_t>(random() % 4096);
+            frames[i].angles[j] = random() % 4 == 0 ? FlexCalibration::NO_ANGLE
+                                                    : static_cast<int16_t>(static_cast<int32_t>(random() % 18001) - 9000);
+        }
+    }
+
+    bool ok = true;
+    for (const size_t count : BATCH_SIZES) {
+        for (const int servo : {-1, 90}) {
+            const char *text = nullptr;
+            const size_t length = bridge.jsonBatch(frames, count, servo, text);
+            const bool same = length > 0 && length == document.encode(frames, count, servo) &&
+                              memcmp(text, document.text, length) == 0;
+            size_t writerBytes = 0;
+            size_t documentBytes = 0;
+            const double writerRate = rate([&] { return bridge.jsonBatch(frames, count, servo, text); }, writerBytes);
+            const double documentRate = rate([&] { return document.encode(frames, count, servo); }, documentBytes);
+            const bool passed = same && writerBytes == documentBytes;
+            ok &= passed;
+            printf("json frames=%zu servo=%d bytes=%zu messages=%zu document_msgs_per_s=%.0f writer_msgs_per_s=%.0f "
+                   "speedup=%.2f %s\n",
+                   count, servo, length, MESSAGES, documentRate, writerRate,
+                   documentRate > 0.0 ? writerRate / documentRate : 0.0, passed ? "PASS" : "FAIL");
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,89 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Logging benchmark: the same message through each form 'SerialStream.h' offers, built at the default SR_LEVEL
+ *  (INFO), so TRACE statements are compiled out.
+ *      >> ns_per_message is host time from the statement to its bytes reaching the output (the simulator has no
+ *         writer task, so each line is drained as it ends), for comparing the forms, not a board figure.
+ *      >> bytes_per_message is what the serial port has to carry.
+ *      >> roundtrip checks a deferred record's layout: its format id and argument as SR_DEFER encoded them.
+ *  Code size isn't measured here; build any object with -DSR_LEVEL=0 and without and compare `size`.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#include <Arduino.h>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "SerialStream.h"
+#include "Bench.h"
+
+namespace {
+    class Capture : public Print {                              // Counts drained bytes, keeps the latest record
+    public:
+        size_t write(const uint8_t c) override { return write(&c, 1); }
+        size_t write(const uint8_t *buffer, const size_t size) override {
+            bytes += size;
+            last.assign(buffer, buffer + size);
+            return size;
+        }
+        uint64_t bytes = 0;
+        std::vector<uint8_t> last;
+    };
+
+    template <typename Statement>
+    void run(const char *form, const uint64_t messages, const std::vector<int32_t> &positions, Statement statement) {
+        Capture capture;
+        sr::setOutput(capture);
+        const auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < messages; i++) statement(positions[i % positions.size()]);
+        const auto ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        sr::setOutput(Serial);
+        printf("log form=%s messages=%llu ns_per_message=%.1f bytes_per_message=%.1f\n", form,
+               static_cast<unsigned long long>(messages), ns / static_cast<double>(messages),
+               static_cast<double>(capture.bytes) / static_cast<double>(messages));
+    }
+}
+
+void bench::logging(const uint64_t seconds) {
+    const uint64_t messages = seconds * 10000;
+    std::vector<int32_t> positions(1024);
+    for (size_t i = 0; i < positions.size(); i++) positions[i] = static_cast<int32_t>((i * 37) % 271);
+    uint32_t rates[sr::LEVELS];
+    for (size_t level = 0; level < sr::LEVELS; level++) {
+        rates[level] = sr::getRateLimit(static_cast<sr::Level>(level));
+        sr::setRateLimit(static_cast<sr::Level>(level), 0); // every message reaches the output
+    }
+    const uint32_t dropsBefore = sr::dropped();
+
+    run("trace_stream", messages, positions, [](const int32_t pos) {
+        sr::trace << "Reached stopAngle. Current position: " << pos << sr::endl;
+    });
+    run("trace_macro", messages, positions, [](const int32_t pos) {
+        SR_LOG(TRACE) << "Reached stopAngle. Current position: " << pos << sr::endl;
+    });
+    run("info_text", messages, positions, [](const int32_t pos) {
+        sr::info << "Reached stopAngle. Current position: " << pos << sr::endl;
+    });
+    run("info_deferred", messages, positions, [](const int32_t pos) {
+        SR_DEFER(INFO, "Reached stopAngle. Current position: %d", pos);
+    });
+
+    Capture capture;
+    sr::setOutput(capture);
+    SR_DEFER(INFO, "Reached stopAngle. Current position: %d", -90);
+    sr::setOutput(Serial);
+    const std::vector<uint8_t> &record = capture.last;
+    const bool roundtrip = record.size() == 11 && record[0] == sr::DEFERRED
+        && record[1] == static_cast<uint8_t>(sr::Level::INFO)
+        && (record[2] | record[3] << 8 | record[4] << 16 | static_cast<uint32_t>(record[5]) << 24)
+            == sr::formatId("Reached stopAngle. Current position: %d")
+        && record[6] == 1
+        && static_cast<int32_t>(record[7] | record[8] << 8 | record[9] << 16 | static_cast<uint32_t>(record[10]) << 24) == -90;
+    printf("log roundtrip=%d drops=%u\n", roundtrip, sr::dropped() - dropsBefore);
+
+    for (size_t level = 0; level < sr::LEVELS; level++) sr::setRateLimit(static_cast<sr::Level>(level), rates[level]);
+}
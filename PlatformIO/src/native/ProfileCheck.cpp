@@ -0,0 +1,91 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  MotionProfile check: plans short, medium, long and zero-length legs, both ways, with TRAPEZOID and S_CURVE under
+ *  two sets of limits, and samples position() to check each move against what 'MotionProfile.h' promises.
+ *      >> position(0) is the start, position(duration) and anything after it the target (end_err, the larger miss).
+ *      >> The velocity, acceleration and (S_CURVE only; TRAPEZOID steps its acceleration) jerk never exceed their
+ *         limits. They're taken as first, second and third differences of position() over a step of STEP_V, STEP_A
+ *         and STEP_J. A difference of a piecewise polynomial is a weighted average of the derivative over its window,
+ *         so it can't overshoot a bound the profile keeps; the slack allowed is float rounding of the positions.
+ *      >> A zero-length leg has no duration and stays put.
+ *  Each line ends with PASS or FAIL; any FAIL makes the check fail.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#include <cmath>
+#include <cstdio>
+#include "MotionProfile.h"
+#include "Bench.h"
+
+namespace {
+    constexpr uint64_t STEP_V = 1000;                           // Difference steps (µs), longer for higher derivatives
+    constexpr uint64_t STEP_A = 5000;                           // so float rounding of position() stays far below
+    constexpr uint64_t STEP_J = 20000;                          // the limits it's compared with
+    constexpr float POSITION_EPSILON = 1e-4f;                   // Float rounding allowed in a position (º)
+    constexpr float LIMIT_SLACK = 1.001f;                       // Relative slack on a limit
+
+    struct Leg {
+        float from;
+        float to;
+    };
+    constexpr Leg LEGS[] = {{0, 0.5f}, {90, 89.5f}, {10, 40}, {0, 170}, {170, 0}, {45, 45}};
+    constexpr MotionProfile::Limits LIMITS[] = {{90, 360, 3600}, {200, 2000, 20000}}; // ServoController defaults first
+
+    /* Largest |n-th difference| / step^n of position() over the move and one window past its end (it rests there) */
+    float maxDerivative(const MotionProfile &profile, const int order, const uint64_t step) {
+        float largest = 0;
+        for (uint64_t t = 0; t <= profile.getDuration() + step; t += step / 4) {
+            float p[4];
+            for (int k = 0; k <= order; k++) p[k] = profile.position(t + k * step);
+            float difference = 0;
+            if (order == 1) difference = p[1] - p[0];
+            if (order == 2) difference = p[2] - 2 * p[1] + p[0];
+            if (order == 3) difference = p[3] - 3 * p[2] + 3 * p[1] - p[0];
+            largest = std::fmax(largest, std::fabs(difference) / std::pow(step * 1e-6f, static_cast<float>(order)));
+        }
+        return largest;
+    }
+
+    /* A limit plus what POSITION_EPSILON in each of the 2^order-weighted positions can add to that difference */
+    bool within(const float value, const float limit, const int order, const uint64_t step) {
+        const float rounding = std::ldexp(POSITION_EPSILON, order) / std::pow(step * 1e-6f, static_cast<float>(order));
+        return value <= limit * LIMIT_SLACK + rounding;
+    }
+
+    bool check(const Leg &leg, const MotionProfile::Limits &limits, const MotionProfile::Shape shape) {
+        MotionProfile profile;
+        const bool planned = profile.plan(leg.from, leg.to, limits, shape);
+        const uint64_t duration = profile.getDuration();
+        const float endErr = std::fmax(std::fabs(profile.position(0) - (duration == 0 ? leg.to : leg.from)),
+                                       std::fmax(std::fabs(profile.position(duration) - leg.to),
+                                                 std::fabs(profile.position(duration + 1000000) - leg.to)));
+        const float velocity = maxDerivative(profile, 1, STEP_V);
+        const float acceleration = maxDerivative(profile, 2, STEP_A);
+        const float jerk = shape == MotionProfile::S_CURVE ? maxDerivative(profile, 3, STEP_J) : 0;
+        const bool ok = planned && endErr <= POSITION_EPSILON && (duration == 0) == (leg.from == leg.to)
+                        && profile.getPeakVelocity() <= limits.velocity * LIMIT_SLACK
+                        && within(velocity, limits.velocity, 1, STEP_V)
+                        && within(acceleration, limits.acceleration, 2, STEP_A)
+                        && (shape != MotionProfile::S_CURVE || within(jerk, limits.jerk, 3, STEP_J));
+        printf("profile shape=%s from=%.1f to=%.1f max_velocity=%.0f max_accel=%.0f max_jerk=%.0f duration_ms=%.1f "
+               "peak=%.2f velocity=%.2f accel=%.1f jerk=%.0f end_err=%.6f %s\n",
+               shape == MotionProfile::S_CURVE ? "S_CURVE" : "TRAPEZOID", leg.from, leg.to, limits.velocity,
+               limits.acceleration, limits.jerk, static_cast<double>(duration) / 1000, profile.getPeakVelocity(),
+               velocity, acceleration, jerk, endErr, ok ? "PASS" : "FAIL");
+        return ok;
+    }
+}
+
+bool bench::profile() {
+    bool ok = true;
+    for (const auto &limits : LIMITS) {
+        for (const Leg &leg : LEGS) {
+            ok &= check(leg, limits, MotionProfile::TRAPEZOID);
+            ok &= check(leg, limits, MotionProfile::S_CURVE);
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,99 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  SpscRing check: one producer and one consumer thread, as the timer and loop() (or the control and network tasks)
+ *  use it on the board, on a ring small enough to be full most of the time.
+ *      >> lossless: the producer retries a refused push, so the consumer must see every item, in order, each intact
+ *         (its payload is derived from its sequence number, so a torn copy shows up).
+ *      >> lossy: the producer drops a refused item, as the bridge does, and the consumer stalls now and then. Items
+ *         must still arrive in increasing order and intact, and delivered + overruns() must equal pushes attempted.
+ *      >> In both, a third thread polls size() as the /metrics gauge does; it must never report more than the
+ *         capacity (size_max).
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include "SpscRing.h"
+#include "Bench.h"
+
+namespace {
+    constexpr uint32_t ITEMS = 200000;                          // Items pushed per run
+    constexpr size_t WORDS = 7;                                 // Payload words, so a copy spans more than one store
+    constexpr size_t CAPACITY = 16;                             // Small, so the ring is full most of the time
+
+    struct Item {
+        uint32_t sequence;
+        uint32_t payload[WORDS];                                // sequence * (i + 1)
+    };
+
+    bool intact(const Item &item) {
+        for (size_t i = 0; i < WORDS; i++) {
+            if (item.payload[i] != item.sequence * static_cast<uint32_t>(i + 1)) return false;
+        }
+        return true;
+    }
+
+    bool run(const bool lossy) {
+        SpscRing<Item, CAPACITY> ring;
+        uint32_t refused = 0;                                   // Producer's count; read after join()
+        std::atomic<bool> finished{false};
+        size_t sizeMax = 0;                                     // Observer's largest size(); read after join()
+        std::thread observer([&] {
+            while (!finished.load(std::memory_order_acquire)) {
+                sizeMax = std::max(sizeMax, ring.size());
+                std::this_thread::yield();
+            }
+        });
+        std::thread producer([&] {
+            for (uint32_t n = 0; n < ITEMS; n++) {
+                Item item{n, {}};
+                for (size_t i = 0; i < WORDS; i++) item.payload[i] = n * static_cast<uint32_t>(i + 1);
+                while (!ring.push(item)) {
+                    refused++;
+                    std::this_thread::yield();                  // full: let the consumer run
+                    if (lossy) break;
+                }
+            }
+            finished.store(true, std::memory_order_release);
+        });
+        uint32_t delivered = 0;
+        uint32_t outOfOrder = 0;
+        uint32_t torn = 0;
+        uint32_t next = 0;                                      // Lowest sequence number still acceptable
+        Item item{};
+        for (;;) {
+            const bool last = finished.load(std::memory_order_acquire); // everything pushed is visible if set
+            while (ring.pop(item)) {
+                if (item.sequence < next || (!lossy && item.sequence != next)) outOfOrder++;
+                if (!intact(item)) torn++;
+                next = item.sequence + 1;
+                delivered++;
+                if (lossy && delivered % 1024 == 0) std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+            if (last) break;
+            std::this_thread::yield();                          // empty: let the producer run (matters on one core)
+        }
+        producer.join();
+        observer.join();
+        const bool counted = lossy ? delivered + ring.overruns() == ITEMS && ring.overruns() == refused && refused > 0
+                                   : delivered == ITEMS;
+        const bool ok = outOfOrder == 0 && torn == 0 && counted && sizeMax <= CAPACITY;
+        printf("ring mode=%s items=%u delivered=%u refused=%u overruns=%u out_of_order=%u torn=%u high_water=%u "
+               "size_max=%zu %s\n",
+               lossy ? "lossy" : "lossless", ITEMS, delivered, refused, ring.overruns(), outOfOrder, torn,
+               ring.highWater(), sizeMax, ok ? "PASS" : "FAIL");
+        return ok;
+    }
+}
+
+bool bench::ring() {
+    const bool lossless = run(false);
+    const bool lossy = run(true);
+    return lossless && lossy;
+}
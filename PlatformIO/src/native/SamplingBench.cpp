@@ -0,0 +1,222 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Sampling benchmark: the unchanged FlexSensorArray and ServoController against the simulated board (see 'Sim.h').
+ *      >> The servo runs are a LOOP sweep (PWM write count), a pass over every setpoint to count the duties the output
+ *         can actually reach, and one ONE_SHOT leg per motion profile (see 'ServoController.h'), comparing how long the
+ *         leg takes and how abruptly the setpoint's velocity changes. The playback runs compare duty-write timing with
+ *         updates made from loop() against a compiled trajectory played by the timer, with loop() stalling at random.
+ *      >> loop() is called once per LOOP_PERIOD of simulated time, the same cadence the bridge's delay(1) gives it on
+ *         the board. Latency is measured from a frame's timestamp to the loop() call that drains it.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#include <Arduino.h>
+#include <chrono>
+#include <cstdio>
+#include "FlexSensorArray.h"
+#include "ServoController.h"
+#include "Sim.h"
+#include "Bench.h"
+
+namespace {
+    constexpr uint64_t LOOP_PERIOD = 1000;                      // Simulated time between loop() calls (µs)
+
+    void runFlex(const uint64_t interval, const uint64_t seconds, const uint32_t jitter) {
+        sim::reset();
+        sim::setTimerJitter(jitter);
+        FlexSensorArray sensors;
+        std::vector<uint64_t> latency;
+        std::vector<uint64_t> spacing;
+        bool first = true;
+        uint64_t lastTimestamp = 0;
+        uint32_t lastSequence = 0;
+        uint32_t gaps = 0;
+        sensors.setFrameNotifier([&](const FlexSensorArray::Frame &frame) {
+            latency.push_back(hal::micros() - frame.timestamp);
+            if (!first) {
+                spacing.push_back(frame.timestamp - lastTimestamp);
+                gaps += frame.sequence - lastSequence - 1;
+            }
+            lastTimestamp = frame.timestamp;
+            lastSequence = frame.sequence;
+            first = false;
+        });
+        sensors.setup();
+        for (uint8_t i = 0; i < FlexSensorArray::SIZE; i++) sensors[i].setPin(A0 + i);
+        sensors.setSamplingInterval(interval);
+        sensors.setActive(true);
+
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t end = sim::now() + seconds * 1000000;
+        while (sim::now() < end) {
+            sim::advance(LOOP_PERIOD);
+            sensors.loop();
+        }
+        const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        sensors.setActive(false);
+
+        const size_t frames = latency.size();
+        uint64_t jitterMax = 0;
+        for (const uint64_t s : spacing) jitterMax = std::max(jitterMax, s > interval ? s - interval : interval - s);
+        printf("sampling interval=%llu frames=%zu rate=%.1f latency_p50=%llu p99=%llu p999=%llu "
+               "jitter_max=%llu gaps=%u overruns=%u speedup=%.0fx\n",
+               static_cast<unsigned long long>(interval), frames, static_cast<double>(frames) / seconds,
+               static_cast<unsigned long long>(bench::percentile(latency, 0.50)),
+               static_cast<unsigned long long>(bench::percentile(latency, 0.99)),
+               static_cast<unsigned long long>(bench::percentile(latency, 0.999)),
+               static_cast<unsigned long long>(jitterMax), gaps, sensors.getOverruns(),
+               wall > 0 ? static_cast<double>(seconds) / wall : 0.0);
+    }
+
+    void runServo(const uint64_t seconds) {
+        sim::reset();
+        ServoController servo;
+        servo.setup();
+        servo.setMotion(ServoController::SWEEP);
+        servo.setTimeDelay(10000);
+        servo.enableMotion();
+        const uint64_t end = sim::now() + seconds * 1000000;
+        while (sim::now() < end) {
+            sim::advance(LOOP_PERIOD);
+            servo.loop();
+        }
+        servo.disableMotion();
+        printf("servo_sweep pwm_writes=%llu last_duty=%u position=%d\n",
+               static_cast<unsigned long long>(sim::pwmWrites(servo.getPin())), sim::pwmDuty(servo.getPin()),
+               servo.getPosition());
+    }
+
+    /* Every setpoint across the range in 0.01º steps: how many distinct duties they reach (the output's real resolution
+     * in degrees) and the largest error between the pulse sent and the ideal one for the setpoint. */
+    void runResolution() {
+        constexpr ServoController::MilliDegrees STEP = 10;
+        sim::reset();
+        ServoController servo;
+        servo.setup();
+        const ServoController::MilliDegrees span = servo.getMaxAngle() * ServoController::MILLI;
+        const double range = static_cast<double>(servo.getPwmMax() - servo.getPwmMin()) * 1000.0;
+        uint32_t lastDuty = UINT32_MAX;
+        uint32_t duties = 0;
+        double errorMax = 0;
+        for (ServoController::MilliDegrees setpoint = 0; setpoint <= span; setpoint += STEP) {
+            servo.setSetpoint(setpoint);
+            if (servo.getDuty() != lastDuty) duties++;
+            lastDuty = servo.getDuty();
+            const double ideal = servo.getPwmMin() * 1000.0 + range * setpoint / span;
+            errorMax = std::max(errorMax, std::abs(static_cast<double>(sim::pwmPulseNs(servo.getPin())) - ideal));
+        }
+        printf("servo_resolution bits=%u duties=%u deg_per_duty=%.3f pulse_err_max_ns=%.0f\n",
+               ServoController::PWM_BITS, duties, static_cast<double>(servo.getMaxAngle()) / (duties - 1), errorMax);
+    }
+
+    /* One ONE_SHOT leg from 0º to 90º, updated every 10 ms: how long it takes, and the largest change in setpoint
+     * velocity from one update to the next (a velocity step; 0 would be perfectly smooth). */
+    void runProfile(const ServoController::Profile profile, const unsigned int velocity) {
+        constexpr unsigned long UPDATE = 10000;
+        sim::reset();
+        ServoController servo;
+        servo.setup();
+        servo.setMotion(ServoController::ONE_SHOT);
+        servo.setStartAngle(0);
+        servo.setStopAngle(90);
+        servo.setTimeDelay(UPDATE);
+        servo.setAngleStep(static_cast<int>(velocity * UPDATE / 1000000));
+        servo.setProfile(profile);
+        servo.setMaxVelocity(velocity);
+        servo.setMaxAccel(velocity * 4);
+        servo.setMaxJerk(velocity * 40);
+        servo.enableMotion();
+        int32_t last = servo.getSetpoint();
+        double lastVelocity = 0, velocityStep = 0;
+        uint64_t updates = 0, finished = 0;
+        while (servo.isActive() && sim::now() < 10000000) {
+            sim::advance(LOOP_PERIOD);
+            servo.loop();
+            if (servo.getSetpoint() == last && servo.isActive()) continue;
+            const double v = (servo.getSetpoint() - last) / 1000.0 / (UPDATE / 1e6);
+            velocityStep = std::max(velocityStep, std::abs(v - lastVelocity));
+            lastVelocity = v;
+            last = servo.getSetpoint();
+            finished = sim::now();
+            updates++;
+        }
+        velocityStep = std::max(velocityStep, std::abs(lastVelocity));  // stopping at the end counts too
+        printf("servo_profile profile=%s max_velocity=%u time_ms=%llu updates=%llu final=%.3f max_velocity_step=%.1f\n",
+               ServoController::profileString(profile), velocity, static_cast<unsigned long long>(finished / 1000),
+               static_cast<unsigned long long>(updates), servo.getSetpoint() / 1000.0, velocityStep);
+    }
+}
+
+namespace {
+    /* An S_CURVE SWEEP between 0º and 90º at 10 ms updates while loop() is held up for 0 – stall µs at random after
+     * each call (the bridge parsing JSON or cleaning up clients), with and without playback: how far apart the duty
+     * writes actually land, and how many updates were lost to ticks coalescing while loop() was busy. */
+    void runPlayback(const bool playback, const uint32_t stall, const uint64_t seconds) {
+        constexpr unsigned long UPDATE = 10000;
+        sim::reset();
+        ServoController servo;
+        uint64_t notifications = 0;
+        servo.addAngleNotify([&](int) { notifications++; });
+        servo.setup();
+        servo.setMotion(ServoController::SWEEP);
+        servo.setStartAngle(0);
+        servo.setStopAngle(90);
+        servo.setTimeDelay(UPDATE);
+        servo.setProfile(ServoController::S_CURVE);
+        servo.setPlayback(playback);
+        notifications = 0;
+        const uint64_t writesBefore = sim::pwmWrites(servo.getPin());
+        servo.enableMotion();
+        uint64_t lastWrite = 0, lastAt = 0, jitterMax = 0;
+        const auto observe = [&] {                              // often enough to see each write (< one per UPDATE)
+            const uint64_t writes = sim::pwmWrites(servo.getPin());
+            if (writes == lastWrite) return;
+            const uint64_t at = sim::pwmWrittenAt(servo.getPin());
+            if (lastAt != 0) {
+                const uint64_t spacing = at - lastAt;
+                jitterMax = std::max(jitterMax, spacing > UPDATE ? spacing - UPDATE : UPDATE - spacing);
+            }
+            lastWrite = writes;
+            lastAt = at;
+        };
+        uint32_t state = 12345;
+        const uint64_t end = sim::now() + seconds * 1000000;
+        while (sim::now() < end) {
+            sim::advance(LOOP_PERIOD);
+            servo.loop();
+            observe();
+            if (stall == 0) continue;
+            state ^= state << 13; state ^= state >> 17; state ^= state << 5;
+            for (uint64_t left = state % (stall + 1); left != 0; ) { // loop() is busy; the timer isn't
+                const uint64_t step = std::min<uint64_t>(left, LOOP_PERIOD);
+                sim::advance(step);
+                observe();
+                left -= step;
+            }
+        }
+        servo.disableMotion();
+        const uint64_t writes = sim::pwmWrites(servo.getPin()) - writesBefore;
+        const uint64_t due = seconds * 1000000 / UPDATE;
+        printf("servo_playback playback=%s stall_max=%u writes=%llu lost=%llu spacing_jitter_max=%llu notifications=%llu\n",
+               servo.getPlayback() ? "ON" : "OFF", stall, static_cast<unsigned long long>(writes),
+               static_cast<unsigned long long>(due > writes ? due - writes : 0),
+               static_cast<unsigned long long>(jitterMax), static_cast<unsigned long long>(notifications));
+    }
+}
+
+void bench::sampling(const uint64_t seconds, const uint32_t jitter) {
+    for (const uint64_t interval : INTERVALS) runFlex(interval, seconds, jitter);
+    runServo(seconds);
+    runResolution();
+    for (const uint32_t stall : {0u, 5000u, 20000u}) {
+        for (const bool playback : {false, true}) runPlayback(playback, stall, seconds);
+    }
+    for (const unsigned int velocity : {100u, 200u}) {
+        for (const auto profile : {ServoController::STEP, ServoController::TRAPEZOID, ServoController::S_CURVE}) {
+            runProfile(profile, velocity);
+        }
+    }
+}
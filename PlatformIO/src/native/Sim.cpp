@@ -0,0 +1,283 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Simulated board: the native implementation of the HAL (see 'Hal.h') and the controls in 'Sim.h'.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#include <Arduino.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include "Hal.h"
+#include "Sim.h"
+
+namespace hal {
+    struct SimTimer {
+        TimerCallback callback;
+        void *arg;
+        const char *name;
+        bool active;
+        uint64_t period;                                        // 0 for one-shot
+        uint64_t deadline;                                      // When the callback is due (µs)
+        uint64_t fireAt;                                        // deadline plus the dispatch jitter
+    };
+}
+
+namespace {
+    constexpr hal::Error ERR_INVALID_ARG = 0x102;               // Same codes as ESP-IDF
+    constexpr hal::Error ERR_INVALID_STATE = 0x103;
+    constexpr size_t PINS = 64;
+    constexpr uint16_t ADC_MAX = 4095;
+
+    uint64_t now_ = 0;
+    bool firing_ = false;                                       // A callback is running (advance() doesn't nest)
+    std::vector<hal::SimTimer *> timers_;
+    uint64_t callbacks_ = 0;
+    uint32_t jitterMax_ = 0;
+    uint32_t jitterState_ = 1;
+    sim::Signal signals_[PINS];
+    uint32_t conversionTime_ = 0;
+    uint64_t adcReads_ = 0;
+    constexpr uint8_t PWM_CHANNELS = 8;                         // LEDC channels on the S3
+    uint32_t pwmDuty_[PINS] = {};
+    uint64_t pwmWrites_[PINS] = {};
+    uint64_t pwmWrittenAt_[PINS] = {};
+    uint8_t pwmChannel_[PINS] = {};                             // Channel + 1 each pin is attached to (0 if none)
+    uint32_t pwmFrequency_[PWM_CHANNELS] = {};
+    uint8_t pwmBits_[PWM_CHANNELS] = {};
+    std::map<std::string, std::vector<uint8_t>> settings_;      // Simulated NVS
+
+    uint32_t nextRandom(uint32_t &state) {                      // xorshift32
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    uint64_t jitter() {
+        return jitterMax_ == 0 ? 0 : nextRandom(jitterState_) % (jitterMax_ + 1);
+    }
+    void arm(hal::SimTimer *timer, const uint64_t delay, const uint64_t period) {
+        timer->active = true;
+        timer->period = period;
+        timer->deadline = now_ + delay;
+        timer->fireAt = timer->deadline + jitter();
+    }
+    hal::SimTimer *nextDue(const uint64_t until) {
+        hal::SimTimer *next = nullptr;
+        for (auto *timer : timers_) {
+            if (!timer->active || timer->fireAt > until) continue;
+            if (next == nullptr || timer->fireAt < next->fireAt) next = timer;
+        }
+        return next;
+    }
+}
+
+namespace hal {
+    uint64_t micros() { return now_; }
+    uint32_t cycles() {                                         // Probes time real work, which takes no virtual time
+        return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+    uint32_t cyclesPerMicro() { return 1000; }
+
+    uint16_t adcRead(const uint8_t pin) {
+        adcReads_++;
+        now_ += conversionTime_;
+        if (pin < PINS && signals_[pin]) return signals_[pin](now_);
+        return sim::fingerFlex(static_cast<uint8_t>(pin - A0), now_);
+    }
+
+    uint32_t adcMilliVolts(const uint16_t reading) {
+        return (reading > ADC_MAX ? ADC_MAX : reading) * sim::ADC_FULL_SCALE / ADC_MAX;
+    }
+    const char *adcCalibrationName() { return "SIMULATED"; }
+
+    /* Same limits as the LEDC driver on the S3: up to 14 bits, and the 80 MHz clock divided down to the frequency has to
+     * leave at least 2^bits counts per period. */
+    uint32_t pwmSetup(const uint8_t channel, const uint32_t frequency, const uint8_t bits) {
+        constexpr uint64_t CLOCK = 80000000;
+        if (channel >= PWM_CHANNELS || frequency == 0 || bits == 0 || bits > 14) return 0;
+        if (CLOCK / frequency < (1ull << bits)) return 0;
+        pwmFrequency_[channel] = frequency;
+        pwmBits_[channel] = bits;
+        return frequency;
+    }
+    void pwmAttach(const uint8_t pin, const uint8_t channel) {
+        if (pin < PINS && channel < PWM_CHANNELS) pwmChannel_[pin] = channel + 1;
+    }
+    void pwmDetach(const uint8_t pin) {
+        if (pin < PINS) pwmChannel_[pin] = 0;
+    }
+    void pwmWrite(const uint8_t channel, const uint32_t duty) {
+        if (channel >= PWM_CHANNELS) return;
+        const uint32_t max = (1u << pwmBits_[channel]) - 1;
+        for (size_t pin = 0; pin < PINS; pin++) {
+            if (pwmChannel_[pin] != channel + 1) continue;
+            pwmDuty_[pin] = duty > max ? max : duty;
+            pwmWrites_[pin]++;
+            pwmWrittenAt_[pin] = now_;
+        }
+    }
+
+    Error timerCreate(const TimerCallback callback, void *arg, const char *name, Timer *timer) {
+        if (callback == nullptr || timer == nullptr) return ERR_INVALID_ARG;
+        *timer = new SimTimer{callback, arg, name, false, 0, 0, 0};
+        timers_.push_back(*timer);
+        return OK;
+    }
+    Error timerStartPeriodic(const Timer timer, const uint64_t periodUs) {
+        if (timer == nullptr || periodUs == 0) return ERR_INVALID_ARG;
+        if (timer->active) return ERR_INVALID_STATE;
+        arm(timer, periodUs, periodUs);
+        return OK;
+    }
+    Error timerStartOnce(const Timer timer, const uint64_t timeoutUs) {
+        if (timer == nullptr) return ERR_INVALID_ARG;
+        if (timer->active) return ERR_INVALID_STATE;
+        arm(timer, timeoutUs, 0);
+        return OK;
+    }
+    Error timerStop(const Timer timer) {
+        if (timer == nullptr) return ERR_INVALID_ARG;
+        if (!timer->active) return ERR_INVALID_STATE;
+        timer->active = false;
+        return OK;
+    }
+    Error timerDelete(const Timer timer) {
+        if (timer == nullptr) return ERR_INVALID_ARG;
+        if (timer->active) return ERR_INVALID_STATE;
+        for (auto it = timers_.begin(); it != timers_.end(); ++it) {
+            if (*it == timer) {
+                timers_.erase(it);
+                break;
+            }
+        }
+        delete timer;
+        return OK;
+    }
+    bool timerActive(const Timer timer) { return timer != nullptr && timer->active; }
+
+    const char *errorName(const Error error) {
+        switch (error) {
+            case OK: return "ESP_OK";
+            case ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+            case ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+            default: return "UNKNOWN ERROR";
+        }
+    }
+
+    size_t settingsLoad(const char *key, void *data, const size_t len) {
+        const auto it = settings_.find(key);
+        if (it == settings_.end() || it->second.size() != len) return 0;
+        std::copy(it->second.begin(), it->second.end(), static_cast<uint8_t *>(data));
+        return len;
+    }
+    bool settingsSave(const char *key, const void *data, const size_t len) {
+        const auto *bytes = static_cast<const uint8_t *>(data);
+        settings_[key].assign(bytes, bytes + len);
+        return true;
+    }
+    bool settingsErase(const char *key) {
+        settings_.erase(key);
+        return true;
+    }
+
+    size_t tasks(TaskInfo (&out)[MAX_TASKS], uint32_t &clock) {
+        clock = static_cast<uint32_t>(now_);
+        out[0] = TaskInfo{1, "sim", clock, 0, NO_CORE, 1, false}; // the one thread, never idle
+        return 1;
+    }
+} // namespace hal
+
+namespace sim {
+    uint64_t now() { return now_; }
+
+    void advance(const uint64_t us) {
+        const uint64_t until = now_ + us;
+        if (firing_) {                                          // delay() inside a callback: time passes, nothing fires
+            now_ = until;
+            return;
+        }
+        firing_ = true;
+        while (hal::SimTimer *timer = nextDue(until)) {
+            if (timer->fireAt > now_) now_ = timer->fireAt;
+            if (timer->period != 0) {
+                timer->deadline += timer->period;
+                timer->fireAt = timer->deadline + jitter();
+            } else {
+                timer->active = false;
+            }
+            callbacks_++;
+            timer->callback(timer->arg);
+        }
+        firing_ = false;
+        if (until > now_) now_ = until;
+    }
+
+    void reset() {
+        now_ = 0;
+        for (auto *timer : timers_) timer->active = false;
+        callbacks_ = 0;
+        jitterMax_ = 0;
+        jitterState_ = 1;
+        for (auto &signal : signals_) signal = nullptr;
+        conversionTime_ = 0;
+        adcReads_ = 0;
+        for (size_t i = 0; i < PINS; i++) {
+            pwmDuty_[i] = 0;
+            pwmWrites_[i] = 0;
+            pwmWrittenAt_[i] = 0;
+            pwmChannel_[i] = 0;
+        }
+        for (uint8_t i = 0; i < PWM_CHANNELS; i++) {
+            pwmFrequency_[i] = 0;
+            pwmBits_[i] = 0;
+        }
+    }
+
+    void setSignal(const uint8_t pin, Signal signal) {
+        if (pin < PINS) signals_[pin] = std::move(signal);
+    }
+    /* ------ Open hand -> closed fist -> open hand, once per ~2 s, each finger slightly out of step with the last ------
+     * Flat and fully bent land around 1400 and 2800 counts (a flex sensor in a divider with a matching resistor), with a
+     * few counts of deterministic noise on top.
+     */
+    uint16_t fingerFlex(const uint8_t finger, const uint64_t us) {
+        constexpr double FLAT = 1400.0;
+        constexpr double BENT = 2800.0;
+        constexpr double TWO_PI = 6.283185307179586;
+        const double period = 2.0e6 + 150.0e3 * finger;
+        const double phase = TWO_PI * (static_cast<double>(us) / period + 0.25 * finger);
+        uint32_t noise = static_cast<uint32_t>(us / 100) * 2654435761u + finger + 1;  // same time, same noise
+        const double value = FLAT + (BENT - FLAT) * (0.5 - 0.5 * std::cos(phase))
+                           + static_cast<double>(nextRandom(noise) % 13) - 6.0;
+        if (value < 0.0) return 0;
+        if (value > ADC_MAX) return ADC_MAX;
+        return static_cast<uint16_t>(value);
+    }
+    void setAdcConversionTime(const uint32_t us) { conversionTime_ = us; }
+    uint64_t adcReads() { return adcReads_; }
+
+    uint32_t pwmDuty(const uint8_t pin) { return pin < PINS ? pwmDuty_[pin] : 0; }
+    uint64_t pwmWrites(const uint8_t pin) { return pin < PINS ? pwmWrites_[pin] : 0; }
+    uint64_t pwmWrittenAt(const uint8_t pin) { return pin < PINS ? pwmWrittenAt_[pin] : 0; }
+    uint64_t pwmPulseNs(const uint8_t pin) {
+        if (pin >= PINS || pwmChannel_[pin] == 0) return 0;
+        const uint8_t channel = pwmChannel_[pin] - 1;
+        if (pwmFrequency_[channel] == 0) return 0;
+        return (static_cast<uint64_t>(pwmDuty_[pin]) * (1000000000ull / pwmFrequency_[channel])) >> pwmBits_[channel];
+    }
+
+    void setTimerJitter(const uint32_t maxUs, const uint32_t seed) {
+        jitterMax_ = maxUs;
+        jitterState_ = seed != 0 ? seed : 1;
+    }
+    uint64_t timerCallbacks() { return callbacks_; }
+
+    void eraseSettings() { settings_.clear(); }
+} // namespace sim
@@ -0,0 +1,31 @@
+/*----------------------------------------------------------------------------------------------------------------------
+ *  BME:4920 - Biomedical Engineering Senior Design II
+ *  Team 13 | Remote Hand Exoskeleton
+ *  Sullivan Bryant, Charley Dunham, Jared Gilliam
+ *
+ *
+ *  Entry point of the `native` environment: runs the benchmarks and checks in 'Bench.h' against the simulated board.
+ *      >> Build and run:  pio run -e native && .pio/build/native/program [sampling|e2e|filter|log|ring|dispatch|json|profile|all] [seconds] [jitter µs]
+ *      >> Exits with 1 if any check failed.
+ *----------------------------------------------------------------------------------------------------------------------*/
+
+#include <cstdlib>
+#include <cstring>
+#include "Bench.h"
+
+int main(const int argc, char **argv) {
+    const char *which = argc > 1 ? argv[1] : "all";
+    const uint64_t seconds = argc > 2 ? strtoull(argv[2], nullptr, 10) : 60;
+    const auto jitter = static_cast<uint32_t>(argc > 3 ? strtoul(argv[3], nullptr, 10) : 0);
+    const bool all = strcmp(which, "all") == 0;
+    if (all || strcmp(which, "sampling") == 0) bench::sampling(seconds, jitter);
+    if (all || strcmp(which, "e2e") == 0) bench::endToEnd(seconds, jitter);
+    bool ok = true;
+    if (all || strcmp(which, "filter") == 0) ok &= bench::filter(seconds);
+    if (all || strcmp(which, "log") == 0) bench::logging(seconds);
+    if (all || strcmp(which, "ring") == 0) ok &= bench::ring();
+    if (all || strcmp(which, "dispatch") == 0) ok &= bench::dispatch();
+    if (all || strcmp(which, "json") == 0) ok &= bench::json();
+    if (all || strcmp(which, "profile") == 0) ok &= bench::profile();
+    return ok ? 0 : 1;
+}
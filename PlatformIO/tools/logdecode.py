@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+# BME:4920 - Biomedical Engineering Senior Design II
+# Team 13 | Remote Hand Exoskeleton
+# Sullivan Bryant, Charley Dunham, Jared Gilliam
+#
+# Prints the board's serial log with SR_DEFER records (see include/SerialStream.h) formatted back into text. Every
+# SR_DEFER format string in the sources (--root, this PlatformIO project by default) is hashed the way sr::formatId()
+# does, so the sources must match the firmware that produced the log. Ordinary lines pass through unchanged.
+#
+#   python3 tools/logdecode.py capture.bin              # a raw capture
+#   python3 tools/logdecode.py --port /dev/cu.usbmodem  # live, at monitor_speed (needs pyserial, bundled with pio)
+#   cat capture.bin | python3 tools/logdecode.py
+
+import argparse
+import codecs
+import pathlib
+import re
+import struct
+import sys
+
+DEFERRED = 0x1E
+LEVELS = ["TRACE", "DEBUG", "INFO", "WARN", "ERROR"]
+CALL = re.compile(rb'SR_DEFER\(\s*\w+\s*,\s*"((?:[^"\\]|\\.)*)"')
+SPEC = re.compile(r"%[-+ #0]*\d*(?:\.\d+)?(?:hh|h|ll|l|z)?([diuxXcfeEgG%])")
+
+
+def format_id(text: bytes) -> int:
+    """32-bit FNV-1a, as sr::formatId()."""
+    value = 2166136261
+    for byte in text:
+        value = ((value ^ byte) * 16777619) & 0xFFFFFFFF
+    return value
+
+
+def load_formats(root: pathlib.Path) -> dict:
+    formats = {}
+    sources = (path for path in root.rglob("*") if path.suffix in (".cpp", ".h", ".ino") and ".pio" not in path.parts)
+    for path in sorted(sources):
+        for match in CALL.finditer(path.read_bytes()):
+            text = codecs.escape_decode(match.group(1))[0]
+            known = formats.setdefault(format_id(text), text)
+            if known != text:
+                print(f"logdecode: {known!r} and {text!r} share an id; rename one", file=sys.stderr)
+    return formats
+
+
+def render(text: bytes, args: list) -> str:
+    """Applies a printf format to raw 32-bit arguments, reading each the way its conversion expects."""
+    values = iter(args)
+    out = []
+    last = 0
+    pattern = text.decode("utf-8", "replace")
+    for spec in SPEC.finditer(pattern):
+        out.append(pattern[last:spec.start()])
+        last = spec.end()
+        kind = spec.group(1)
+        if kind == "%":
+            out.append("%")
+            continue
+        raw = next(values, 0)
+        python = re.sub(r"(hh|h|ll|l|z)", "", spec.group(0))
+        if kind in "di":
+            out.append(python % struct.unpack("<i", struct.pack("<I", raw))[0])
+        elif kind in "fFeEgG":
+            out.append(python % struct.unpack("<f", struct.pack("<I", raw))[0])
+        elif kind == "c":
+            out.append(chr(raw & 0xFF))
+        else:
+            out.append(python.replace("u", "d") % raw)
+    out.append(pattern[last:])
+    return "".join(out)
+
+
+def decode(read, write, formats: dict) -> None:
+    text = codecs.getincrementaldecoder("utf-8")("replace")  # a character may straddle two reads
+    pending = bytearray()
+    while True:
+        chunk = read()
+        if not chunk:
+            break
+        pending += chunk
+        while pending:
+            start = pending.find(DEFERRED)
+            if start != 0:                                  # text up to the next record (or all of it)
+                end = len(pending) if start < 0 else start
+                write(text.decode(bytes(pending[:end])))
+                del pending[:end]
+                continue
+            if len(pending) < 7 or len(pending) < 7 + 4 * pending[6]:
+                break                                       # wait for the rest of the record
+            level, fid, count = pending[1], struct.unpack_from("<I", pending, 2)[0], pending[6]
+            args = list(struct.unpack_from(f"<{count}I", pending, 7))
+            del pending[:7 + 4 * count]
+            if fid in formats:
+                write(render(formats[fid], args) + "\n")
+            else:
+                name = LEVELS[level] if level < len(LEVELS) else level
+                write(f"[{name}] unknown format {fid:08x}: {args}\n")
+    write(text.decode(bytes(pending), final=True))
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Decode SR_DEFER records in the board's serial log.")
+    parser.add_argument("capture", nargs="?", help="raw capture file (stdin if omitted)")
+    parser.add_argument("--port", help="read a serial port instead")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--root", default=pathlib.Path(__file__).resolve().parent.parent, type=pathlib.Path,
+                        help="sources the firmware was built from (PlatformIO project or ArduinoIDE sketch)")
+    options = parser.parse_args()
+    formats = load_formats(options.root)
+
+    def write(text: str) -> None:
+        sys.stdout.write(text)
+        sys.stdout.flush()
+
+    if options.port:
+        import serial
+        with serial.Serial(options.port, options.baud) as port:     # blocks until at least a byte arrives
+            decode(lambda: port.read(max(1, port.in_waiting)), write, formats)
+    elif options.capture:
+        with open(options.capture, "rb") as capture:
+            decode(lambda: capture.read(4096), write, formats)
+    else:
+        decode(lambda: sys.stdin.buffer.read1(4096), write, formats)
+
+
+if __name__ == "__main__":
+    main()